@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+
+    OSCBundleBenchmark.cpp
+    Packets/sec and bytes/sec with one datagram per event versus one bundle
+    per processBlock.
+
+    Simulates dense passages at 48 kHz / 128-sample blocks and sends the
+    result to a local UDP sink. Rates are given per second of audio (what
+    the server receives in real time) alongside the time spent sending.
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include <cstdio>
+#include <vector>
+#include "../Source/OSCEncoder.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 128;
+    constexpr double secondsOfAudio = 10.0;
+
+    using Block = std::vector<OSCEvent>;
+
+    // Eight-note chords struck and released every block
+    Block makeChordBlock(juce::uint32 blockIndex)
+    {
+        Block block;
+
+        for (int i = 0; i < 8; ++i)
+        {
+            OSCEvent event;
+            event.status = (blockIndex % 2 == 0) ? 0x90 : 0x80;
+            event.data1 = (juce::uint8) (48 + i * 3);
+            event.data2 = (blockIndex % 2 == 0) ? 96 : 0;
+            event.samplePosition = i;
+            event.blockIndex = blockIndex;
+            block.push_back(event);
+        }
+
+        return block;
+    }
+
+    // Three controllers sweeping, 16 values each per block
+    Block makeControllerSweepBlock(juce::uint32 blockIndex)
+    {
+        Block block;
+
+        for (int i = 0; i < 16; ++i)
+        {
+            for (juce::uint8 controller : { (juce::uint8) 1, (juce::uint8) 7, (juce::uint8) 11 })
+            {
+                OSCEvent event;
+                event.status = 0xb0;
+                event.data1 = controller;
+                event.data2 = (juce::uint8) ((blockIndex * 16 + (juce::uint32) i) % 128);
+                event.samplePosition = i * blockSize / 16;
+                event.blockIndex = blockIndex;
+                block.push_back(event);
+            }
+        }
+
+        return block;
+    }
+
+    struct Totals
+    {
+        long long packets = 0;
+        long long bytes = 0;
+        double sendSeconds = 0;
+    };
+
+    template <typename BlockFactory>
+    Totals run(BlockFactory makeBlock, bool bundle, const OSCTagSuffix& tagSuffix, juce::DatagramSocket& socket, int sinkPort)
+    {
+        juce::HeapBlock<char> messageBuffer(OSCEventEncoder::maxPacketSize);
+        juce::HeapBlock<char> bundleBuffer(OSCEventEncoder::maxPacketSize);
+        OSCPacketWriter writer(messageBuffer.getData(), OSCEventEncoder::maxPacketSize);
+        OSCBundleBuilder bundleBuilder(bundleBuffer.getData(), OSCEventEncoder::maxPacketSize);
+        bundleBuilder.setMaxDatagramSize(OSCEventEncoder::defaultMaxDatagramSize);
+
+        Totals totals;
+        auto sendPacket = [&](const char* data, size_t size)
+        {
+            socket.write("127.0.0.1", sinkPort, data, (int) size);
+            ++totals.packets;
+            totals.bytes += (long long) size;
+        };
+
+        const auto numBlocks = (juce::uint32) (secondsOfAudio * sampleRate / blockSize);
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (juce::uint32 blockIndex = 1; blockIndex <= numBlocks; ++blockIndex)
+        {
+            for (const auto& event : makeBlock(blockIndex))
+            {
+                writer.reset();
+                OSCEventEncoder::writeEvent(writer, event, tagSuffix);
+
+                if (bundle)
+                    bundleBuilder.addMessage(writer.getData(), writer.getSize(), sendPacket);
+                else
+                    sendPacket(writer.getData(), writer.getSize());
+            }
+
+            bundleBuilder.flush(sendPacket);
+        }
+
+        totals.sendSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        return totals;
+    }
+
+    void report(const char* name, const Totals& totals)
+    {
+        std::printf("%-28s %10.0f packets/s %12.0f bytes/s   (%.3f s to send)\n",
+                    name,
+                    (double) totals.packets / secondsOfAudio,
+                    (double) totals.bytes / secondsOfAudio,
+                    totals.sendSeconds);
+    }
+}
+
+int main()
+{
+    const auto tagSuffix = OSCTagSuffix::fromTags({ "strings_section_a", "violins_1", "legato" });
+
+    juce::DatagramSocket sink;
+    sink.bindToPort(0, "127.0.0.1");
+    const auto sinkPort = sink.getBoundPort();
+    juce::DatagramSocket socket;
+
+    std::printf("OSC bundle benchmark: %.0f s of audio at %.0f Hz, %d-sample blocks, %d-byte datagrams\n\n",
+                secondsOfAudio, sampleRate, blockSize, (int) OSCEventEncoder::defaultMaxDatagramSize);
+
+    report("chords, per event", run(makeChordBlock, false, tagSuffix, socket, sinkPort));
+    report("chords, per block bundle", run(makeChordBlock, true, tagSuffix, socket, sinkPort));
+    report("CC sweep, per event", run(makeControllerSweepBlock, false, tagSuffix, socket, sinkPort));
+    report("CC sweep, per block bundle", run(makeControllerSweepBlock, true, tagSuffix, socket, sinkPort));
+
+    return 0;
+}
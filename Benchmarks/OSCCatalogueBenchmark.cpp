@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    OSCCatalogueBenchmark.cpp
+    Full catalogue rebroadcasts versus versioned deltas.
+
+    Before the catalogue protocol, every change meant the server sending the
+    whole tag list again and the receiver copying all of it. Here a server
+    with N instruments changes five of them per update. Reports the bytes on
+    the wire and the receive-side cost per update for a full snapshot and
+    for a delta applied to OSCTagCatalogue.
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../Source/OSCEncoder.h"
+#include "../Source/OSCTagCatalogue.h"
+
+namespace
+{
+    constexpr int numUpdates = 200;
+
+    std::string makeTag(int index)
+    {
+        return "instrument_" + std::to_string(index);
+    }
+
+    // Encodes a message of int arguments followed by string arguments
+    size_t encode(juce::HeapBlock<char>& buffer, size_t capacity, const char* address,
+                  const std::vector<int>& ints, const std::vector<std::string>& strings)
+    {
+        OSCPacketWriter writer(buffer.getData(), capacity);
+        writer.writeString(address);
+
+        std::string typeTags = ",";
+        typeTags.append(ints.size(), 'i');
+        typeTags.append(strings.size(), 's');
+        writer.writeString(typeTags.c_str());
+
+        for (auto value : ints)
+            writer.writeInt32(value);
+
+        for (const auto& string : strings)
+            writer.writeString(string.c_str());
+
+        return writer.hasOverflowed() ? 0 : writer.getSize();
+    }
+
+    double secondsSince(juce::int64 start)
+    {
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    }
+}
+
+int main()
+{
+    std::printf("OSC catalogue benchmark: %d updates of 5 changed tags\n\n", numUpdates);
+    std::printf("%10s %14s %12s %14s %12s\n", "tags", "snapshot B", "snapshot us", "delta B", "delta us");
+
+    constexpr size_t capacity = 1 << 20;
+    juce::HeapBlock<char> buffer(capacity);
+
+    for (auto numTags : { 100, 1000, 5000, 20000 })
+    {
+        std::vector<std::string> tags;
+
+        for (int i = 0; i < numTags; ++i)
+            tags.push_back(makeTag(i));
+
+        // Full snapshot: parse the whole list and rebuild the set every update
+        size_t snapshotSize = 0;
+        double snapshotSeconds = 0.0;
+        OSCTagCatalogueSync fullSync;
+
+        for (int update = 0; update < numUpdates; ++update)
+        {
+            snapshotSize = encode(buffer, capacity, OSCTagCatalogueSync::snapshotAddress, { update + 1, 0, 1 }, tags);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            OSCMessageView view;
+            view.parse(buffer.getData(), snapshotSize);
+            fullSync.handleMessage(view);
+            snapshotSeconds += secondsSince(start);
+        }
+
+        // Deltas: swap five tags per update on top of one snapshot
+        OSCTagCatalogueSync deltaSync;
+        {
+            OSCMessageView view;
+            view.parse(buffer.getData(), encode(buffer, capacity, OSCTagCatalogueSync::snapshotAddress, { 1, 0, 1 }, tags));
+            deltaSync.handleMessage(view);
+        }
+
+        size_t deltaSize = 0;
+        double deltaSeconds = 0.0;
+
+        for (int update = 0; update < numUpdates; ++update)
+        {
+            std::vector<std::string> changes;
+
+            for (int i = 0; i < 5; ++i)
+                changes.push_back(makeTag(numTags + update * 5 + i));
+
+            for (int i = 0; i < 5; ++i)
+                changes.push_back(makeTag(update * 5 + i));
+
+            deltaSize = encode(buffer, capacity, OSCTagCatalogueSync::deltaAddress, { update + 2, 5 }, changes);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            OSCMessageView view;
+            view.parse(buffer.getData(), deltaSize);
+            deltaSync.handleMessage(view);
+            deltaSeconds += secondsSince(start);
+        }
+
+        std::printf("%10d %14d %12.1f %14d %12.1f\n", numTags,
+                    (int) snapshotSize, snapshotSeconds * 1.0e6 / numUpdates, (int) deltaSize, deltaSeconds * 1.0e6 / numUpdates);
+
+        if (deltaSync.getCatalogue().size() != numTags)
+            std::printf("  unexpected catalogue size %d\n", deltaSync.getCatalogue().size());
+    }
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    OSCCompactTagsBenchmark.cpp
+    Bytes on the wire with string tags versus a registered tag handle.
+
+    Synthetic 16-channel workload: one plugin instance per MIDI channel, each
+    routed to an instrument with long, descriptive tag names, playing notes
+    with mod-wheel and expression automation for one minute.
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include <cstdio>
+#include "../Source/OSCEncoder.h"
+
+namespace
+{
+    constexpr int numChannels = 16;
+    constexpr double secondsOfAudio = 60.0;
+    constexpr int notesPerSecond = 8;
+    constexpr int controllersPerSecond = 100;
+
+    juce::StringArray makeInstrumentTags(int channel)
+    {
+        return { "orchestral_template/section_" + juce::String(channel + 1),
+                 "library_vendor/instrument_" + juce::String(channel + 1) + "_long_sustain",
+                 "articulation/legato_con_vibrato" };
+    }
+
+    long long measureWorkloadBytes(bool useHandles)
+    {
+        juce::HeapBlock<char> buffer(OSCEventEncoder::maxPacketSize);
+        OSCPacketWriter writer(buffer.getData(), OSCEventEncoder::maxPacketSize);
+        long long totalBytes = 0;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto suffix = useHandles ? OSCTagSuffix::fromHandle(channel + 1)
+                                           : OSCTagSuffix::fromTags(makeInstrumentTags(channel));
+
+            auto encode = [&](juce::uint8 status, juce::uint8 data1, juce::uint8 data2)
+            {
+                OSCEvent event;
+                event.status = (juce::uint8) (status | channel);
+                event.data1 = data1;
+                event.data2 = data2;
+
+                writer.reset();
+                OSCEventEncoder::writeEvent(writer, event, suffix);
+                totalBytes += (long long) writer.getSize();
+            };
+
+            for (int i = 0; i < (int) (secondsOfAudio * notesPerSecond); ++i)
+            {
+                encode(0x90, (juce::uint8) (48 + i % 24), 100);
+                encode(0x80, (juce::uint8) (48 + i % 24), 0);
+            }
+
+            for (int i = 0; i < (int) (secondsOfAudio * controllersPerSecond); ++i)
+                encode(0xb0, (i % 2 == 0) ? 1 : 11, (juce::uint8) (i % 128));
+        }
+
+        return totalBytes;
+    }
+}
+
+int main()
+{
+    const auto stringBytes = measureWorkloadBytes(false);
+    const auto handleBytes = measureWorkloadBytes(true);
+
+    std::printf("Compact tag benchmark: %d channels, %.0f s, %d notes/s and %d CCs/s per channel\n\n",
+                numChannels, secondsOfAudio, notesPerSecond, controllersPerSecond);
+    std::printf("%-16s %12lld bytes %10.0f bytes/s\n", "string tags", stringBytes, (double) stringBytes / secondsOfAudio);
+    std::printf("%-16s %12lld bytes %10.0f bytes/s\n", "tag handles", handleBytes, (double) handleBytes / secondsOfAudio);
+    std::printf("\nReduction: %.1f%%\n", 100.0 * (1.0 - (double) handleBytes / (double) stringBytes));
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+/*
+  ==============================================================================
+
+    OSCControllerCoalescerBenchmark.cpp
+    Events per second through OSCControllerCoalescer on all 16 channels,
+    after checking that it keeps every channel apart.
+
+    The check runs first and makes the benchmark exit with status 1 if the
+    output is wrong: dense CCs on every channel from 1 to 16 must each
+    coalesce to their last value ahead of the channel's note, and a value
+    held back by the minimum interval on channel 16 must be released by a
+    note on channel 16 only. A note that no longer fits after its channel's
+    held-back values must be reported as truncated, not dropped. Configure
+    with -DOSC_CLIENT_SANITIZE=address to have any out-of-range slot or
+    channel index caught as well.
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include <cstdio>
+#include <vector>
+#include "../Source/OSCControllerCoalescer.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 128;
+    constexpr int numBlocks = 20000;
+    constexpr int maxOutput = 2048;
+
+    OSCEvent makeEvent(juce::uint8 status, int channel, int data1, int data2, int samplePosition)
+    {
+        OSCEvent event;
+        event.status = static_cast<juce::uint8>(status | (channel - 1));
+        event.data1 = static_cast<juce::uint8>(data1);
+        event.data2 = static_cast<juce::uint8>(data2);
+        event.samplePosition = samplePosition;
+        return event;
+    }
+
+    // 32 values of CC74 on every channel, interleaved, then a note on each
+    std::vector<OSCEvent> makeBlock()
+    {
+        std::vector<OSCEvent> block;
+
+        for (int step = 0; step < 32; ++step)
+            for (int channel = 1; channel <= 16; ++channel)
+                block.push_back(makeEvent(0xb0, channel, 74, step, step * blockSize / 32));
+
+        for (int channel = 1; channel <= 16; ++channel)
+            block.push_back(makeEvent(0x90, channel, 60, 100, blockSize - 1));
+
+        return block;
+    }
+
+    int checkFailed(const char* what)
+    {
+        std::printf("Coalescer check failed: %s\n", what);
+        return 1;
+    }
+
+    int checkChannels()
+    {
+        OSCControllerCoalescer coalescer;
+        std::vector<OSCEvent> output(maxOutput);
+        const auto block = makeBlock();
+
+        int numTruncated = 0;
+        const auto numOutput = coalescer.process(block.data(), (int) block.size(), output.data(), maxOutput,
+                                                 {}, 0.0, sampleRate, 1, numTruncated);
+
+        if (numOutput != 32 || numTruncated != 0)
+            return checkFailed("expected one CC and one note per channel");
+
+        for (int channel = 1; channel <= 16; ++channel)
+        {
+            int numControllers = 0;
+            bool noteSeen = false;
+
+            for (int i = 0; i < numOutput; ++i)
+            {
+                const auto& event = output[(size_t) i];
+
+                if (event.getChannel() != channel)
+                    continue;
+
+                if (event.isController())
+                {
+                    if (noteSeen || event.data2 != 31)
+                        return checkFailed("a channel's last CC value did not come before its note");
+
+                    ++numControllers;
+                }
+                else
+                {
+                    noteSeen = true;
+                }
+            }
+
+            if (numControllers != 1 || !noteSeen)
+                return checkFailed("a channel lost or duplicated events");
+        }
+
+        // Held back on channel 16, released by its note and not channel 1's
+        OSCControllerFilter filter;
+        filter.minIntervalMs = 10.0;
+
+        const OSCEvent first[] = { makeEvent(0xb0, 16, 1, 10, 0) };
+        coalescer.process(first, 1, output.data(), maxOutput, filter, 1.0, sampleRate, 2, numTruncated);
+
+        const OSCEvent second[] = { makeEvent(0xb0, 16, 1, 20, 0),
+                                    makeEvent(0x90, 1, 60, 100, 1),
+                                    makeEvent(0x90, 16, 60, 100, 2) };
+        const auto numSecond = coalescer.process(second, 3, output.data(), maxOutput, filter, 1.001, sampleRate, 3, numTruncated);
+
+        if (numSecond != 3 || !output[0].isNoteOn() || output[0].getChannel() != 1
+            || !output[1].isController() || output[1].getChannel() != 16 || output[1].data2 != 20
+            || !output[2].isNoteOn() || output[2].getChannel() != 16)
+            return checkFailed("a held-back CC on channel 16 was not released by its own note");
+
+        // A note whose held-back CCs use up the output is left for the caller
+        // to count, never dropped after them
+        OSCControllerCoalescer held;
+        const OSCEvent sent[] = { makeEvent(0xb0, 2, 1, 10, 0), makeEvent(0xb0, 2, 2, 10, 0), makeEvent(0xb0, 2, 3, 10, 0) };
+        held.process(sent, 3, output.data(), maxOutput, filter, 1.0, sampleRate, 4, numTruncated);
+
+        const OSCEvent deferred[] = { makeEvent(0xb0, 2, 1, 20, 0), makeEvent(0xb0, 2, 2, 20, 0), makeEvent(0xb0, 2, 3, 20, 0),
+                                      makeEvent(0x80, 2, 60, 0, 1) };
+        const auto numDeferred = held.process(deferred, 4, output.data(), 3, filter, 1.001, sampleRate, 5, numTruncated);
+
+        if (numDeferred != 0 || numTruncated != 1)
+            return checkFailed("a note that did not fit after its held-back CCs was not counted as truncated");
+
+        const auto numRetried = held.process(deferred + 3, 1, output.data(), 4, filter, 1.002, sampleRate, 6, numTruncated);
+
+        if (numRetried != 4 || numTruncated != 0 || !output[3].isNoteOff() || output[2].data2 != 20)
+            return checkFailed("held-back CCs and their note did not go out together once there was room");
+
+        // Whatever does not fit in the output is reported, not lost silently
+        OSCControllerCoalescer small;
+        small.process(block.data(), (int) block.size(), output.data(), 100, {}, 0.0, sampleRate, 1, numTruncated);
+
+        if (numTruncated != (int) block.size() - 100)
+            return checkFailed("events cut off at maxOutput were not counted");
+
+        return 0;
+    }
+}
+
+int main()
+{
+    if (checkChannels() != 0)
+        return 1;
+
+    OSCControllerCoalescer coalescer;
+    std::vector<OSCEvent> output(maxOutput);
+    auto block = makeBlock();
+    juce::uint64 numIn = 0, numOut = 0;
+    int numTruncated = 0;
+
+    const auto start = juce::Time::getHighResolutionTicks();
+
+    for (int i = 0; i < numBlocks; ++i)
+    {
+        numIn += block.size();
+        numOut += (juce::uint64) coalescer.process(block.data(), (int) block.size(), output.data(), maxOutput, {},
+                                                   i * blockSize / sampleRate, sampleRate, (juce::uint32) i + 1, numTruncated);
+    }
+
+    const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    std::printf("Controller coalescer benchmark: %d blocks of %d events on 16 channels\n\n", numBlocks, (int) block.size());
+    std::printf("%14s %14s %12s %16s\n", "events in", "events out", "ns/event", "events/s");
+    std::printf("%14llu %14llu %12.1f %16.0f\n", (unsigned long long) numIn, (unsigned long long) numOut,
+                seconds * 1.0e9 / (double) numIn, (double) numIn / seconds);
+    return 0;
+}
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    OSCDispatcherBenchmark.cpp
+    Trie dispatch in OSCAddressDispatcher versus a linear scan of handlers.
+
+    Registers thousands of per-instrument addresses plus a few wildcard
+    patterns, then looks up a mix of addresses that hit and miss. The scan
+    is what routing looks like with one string comparison per handler.
+    Reports ns/lookup for each registry size.
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../Source/OSCAddressDispatcher.h"
+
+namespace
+{
+    constexpr int numLookups = 200000;
+
+    const char* const leaves[] = { "note_on", "note_off", "controller", "level", "mute" };
+
+    std::string makeAddress(int instrument, int leaf)
+    {
+        return "/instrument/" + std::to_string(instrument) + "/" + leaves[leaf % 5];
+    }
+
+    template <typename Body>
+    double measureNsPerLookup(const std::vector<std::string>& addresses, Body&& body)
+    {
+        volatile int sink = 0;
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numLookups; ++i)
+            sink = sink + body(addresses[static_cast<size_t>(i) % addresses.size()]);
+
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1.0e9 / numLookups;
+    }
+}
+
+int main()
+{
+    std::printf("OSC dispatcher benchmark: %d lookups per run\n\n", numLookups);
+    std::printf("%10s %16s %16s %10s\n", "handlers", "linear ns", "trie ns", "speed-up");
+
+    for (auto numInstruments : { 200, 1000, 4000, 10000 })
+    {
+        OSCAddressDispatcher dispatcher;
+        std::vector<std::string> registered;
+        int numCalls = 0;
+
+        for (int instrument = 0; instrument < numInstruments; ++instrument)
+        {
+            for (int leaf = 0; leaf < 5; ++leaf)
+            {
+                registered.push_back(makeAddress(instrument, leaf));
+                dispatcher.addHandler(registered.back(), [&numCalls](const OSCMessageView&, juce::uint64) { ++numCalls; });
+            }
+        }
+
+        // A few wildcard routes on top, as a client would register for server broadcasts
+        for (auto* pattern : { "/server/{status,heartbeat}", "/instrument/*/meter", "/bank/[0-9]/program", "/catalogue/*" })
+            dispatcher.addHandler(pattern, [&numCalls](const OSCMessageView&, juce::uint64) { ++numCalls; });
+
+        // Three hits for every miss, spread over the registry
+        std::vector<std::string> lookups;
+        juce::Random random(42);
+
+        for (int i = 0; i < 1024; ++i)
+        {
+            const auto instrument = random.nextInt(numInstruments);
+
+            if (i % 4 == 3)
+                lookups.push_back("/instrument/" + std::to_string(instrument) + "/unknown");
+            else
+                lookups.push_back(makeAddress(instrument, random.nextInt(5)));
+        }
+
+        const auto linearNs = measureNsPerLookup(lookups, [&registered](const std::string& address)
+        {
+            int matches = 0;
+
+            for (const auto& candidate : registered)
+                if (candidate == address)
+                    ++matches;
+
+            return matches;
+        });
+
+        const auto trieNs = measureNsPerLookup(lookups, [&dispatcher](const std::string& address)
+        {
+            return dispatcher.forEachMatch(address, [](const OSCAddressDispatcher::Handler&) {});
+        });
+
+        std::printf("%10d %16.1f %16.1f %9.1fx\n", numInstruments * 5, linearNs, trieNs, linearNs / trieNs);
+    }
+
+    return 0;
+}
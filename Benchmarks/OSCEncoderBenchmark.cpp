@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    OSCEncoderBenchmark.cpp
+    Compares the juce::OSCMessage/OSCSender path with OSCPacketWriter.
+
+    Reports ns/event and heap allocations/event for a mix of note-on, note-off
+    and controller events carrying a handful of tags, in both the string and
+    raw MIDI ('m') wire formats. Both paths send to a
+    local UDP sink so the syscall cost is included on each side.
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include <juce_osc/juce_osc.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "../Source/OSCEncoder.h"
+
+//==============================================================================
+// Counts every global heap allocation made while the benchmark runs
+static std::atomic<long long> allocationCount { 0 };
+
+void* operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (auto* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)                  { return operator new(size); }
+void operator delete(void* p) noexcept                  { std::free(p); }
+void operator delete[](void* p) noexcept                { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept     { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept   { std::free(p); }
+
+//==============================================================================
+namespace
+{
+    constexpr int numEvents = 200000;
+
+    OSCEvent makeEvent(int index)
+    {
+        OSCEvent event;
+
+        switch (index % 3)
+        {
+            case 0:  event.status = 0x90; event.data1 = (juce::uint8) (36 + index % 48); event.data2 = 100; break;
+            case 1:  event.status = 0x80; event.data1 = (juce::uint8) (36 + index % 48); event.data2 = 0;   break;
+            default: event.status = 0xb0; event.data1 = 1; event.data2 = (juce::uint8) (index % 128);       break;
+        }
+
+        return event;
+    }
+
+    // The message layout the processor built with juce::OSCMessage before the encoder existed
+    juce::OSCMessage makeJuceMessage(const OSCEvent& event, const juce::StringArray& tags)
+    {
+        const float timestamp = 0;
+        juce::OSCMessage message("/null");
+
+        if (event.isNoteOn())
+            message = juce::OSCMessage("/midi/message", juce::String("note_on"), (int) event.data1, (int) event.data2, timestamp);
+        else if (event.isNoteOff())
+            message = juce::OSCMessage("/midi/message", juce::String("note_off"), (int) event.data1, timestamp);
+        else if (event.isController())
+            message = juce::OSCMessage("/midi/message", juce::String("controller"), (int) event.data1, (int) event.data2, timestamp);
+
+        for (const auto& tag : tags)
+            message.addString(tag);
+
+        return message;
+    }
+
+    struct Result
+    {
+        double nsPerEvent;
+        double allocationsPerEvent;
+    };
+
+    template <typename Body>
+    Result measure(Body&& body)
+    {
+        const auto allocationsBefore = allocationCount.load();
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numEvents; ++i)
+            body(i);
+
+        const auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        const auto allocations = allocationCount.load() - allocationsBefore;
+
+        return { elapsed * 1.0e9 / numEvents, (double) allocations / numEvents };
+    }
+
+    void report(const char* name, Result result)
+    {
+        std::printf("%-32s %10.1f ns/event %10.2f allocations/event\n", name, result.nsPerEvent, result.allocationsPerEvent);
+    }
+}
+
+int main()
+{
+    const juce::StringArray tags { "strings_section_a", "violins_1", "legato" };
+    const auto tagSuffix = OSCTagSuffix::fromTags(tags);
+
+    juce::DatagramSocket sink;
+    sink.bindToPort(0, "127.0.0.1");
+    const auto sinkPort = sink.getBoundPort();
+
+    juce::OSCSender juceSender;
+    juceSender.connect("127.0.0.1", sinkPort);
+
+    juce::DatagramSocket socket;
+    juce::HeapBlock<char> buffer(OSCEventEncoder::maxPacketSize);
+    OSCPacketWriter writer(buffer.getData(), OSCEventEncoder::maxPacketSize);
+
+    std::printf("OSC encoder benchmark: %d events, %d tags, UDP sink on port %d\n\n", numEvents, tags.size(), sinkPort);
+
+    report("juce::OSCMessage encode", measure([&](int i)
+    {
+        auto message = makeJuceMessage(makeEvent(i), tags);
+        juce::ignoreUnused(message);
+    }));
+
+    report("OSCPacketWriter encode", measure([&](int i)
+    {
+        writer.reset();
+        OSCEventEncoder::writeEvent(writer, makeEvent(i), tagSuffix);
+    }));
+
+    report("OSCPacketWriter raw MIDI encode", measure([&](int i)
+    {
+        writer.reset();
+        OSCEventEncoder::writeMidiEvent(writer, makeEvent(i), tagSuffix);
+    }));
+
+    report("juce::OSCSender encode+send", measure([&](int i)
+    {
+        juceSender.send(makeJuceMessage(makeEvent(i), tags));
+    }));
+
+    report("OSCPacketWriter encode+send", measure([&](int i)
+    {
+        writer.reset();
+        OSCEventEncoder::writeEvent(writer, makeEvent(i), tagSuffix);
+        socket.write("127.0.0.1", sinkPort, writer.getData(), (int) writer.getSize());
+    }));
+
+    return 0;
+}
@@ -0,0 +1,206 @@
+/*
+  ==============================================================================
+
+    OSCParserBenchmark.cpp
+    The MemoryInputStream parser OSCMulticastReceiver used to have versus
+    OSCMessageView.
+
+    The old parser built every string one readByte() at a time and turned
+    each int and float into a juce::String. OSCMessageView validates the
+    datagram in one pass and hands out views into it. Reports ns/message and
+    heap allocations/message for a tag list, a numeric message and the
+    small acknowledgement the server sends.
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "../Source/OSCEncoder.h"
+#include "../Source/OSCParser.h"
+
+//==============================================================================
+// Counts every global heap allocation made while the benchmark runs
+static std::atomic<long long> allocationCount { 0 };
+
+void* operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (auto* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)                  { return operator new(size); }
+void operator delete(void* p) noexcept                  { std::free(p); }
+void operator delete[](void* p) noexcept                { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept     { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept   { std::free(p); }
+
+//==============================================================================
+namespace
+{
+    constexpr int numMessages = 200000;
+
+    // The parser as it was in OSC.h, minus the logging
+    namespace Legacy
+    {
+        juce::String readAlignedString(juce::MemoryInputStream& stream)
+        {
+            juce::String result;
+
+            char c;
+            while ((c = stream.readByte()) != '\0')
+            {
+                result += c;
+            }
+
+            int padding = (4 - (result.length() + 1) % 4) % 4;
+            stream.skipNextBytes(padding);
+
+            return result;
+        }
+
+        int parse(const char* data, size_t size)
+        {
+            juce::MemoryInputStream stream(data, size, false);
+            juce::Array<juce::String> arguments;
+
+            const auto addressPattern = readAlignedString(stream);
+            const auto typeTagString = readAlignedString(stream);
+
+            if (!typeTagString.startsWithChar(','))
+                return 0;
+
+            for (int i = 1; i < typeTagString.length(); ++i)
+            {
+                switch (typeTagString[i])
+                {
+                    case 's': arguments.add(readAlignedString(stream)); break;
+                    case 'f': arguments.add(juce::String(stream.readFloatBigEndian())); break;
+                    case 'i': arguments.add(juce::String(stream.readIntBigEndian())); break;
+                    default:  break;
+                }
+            }
+
+            return arguments.size() + addressPattern.length();
+        }
+    }
+
+    int parseWithView(const char* data, size_t size)
+    {
+        OSCMessageView view;
+
+        if (!view.parse(data, size))
+            return 0;
+
+        int checksum = static_cast<int>(view.getAddress().size());
+
+        for (const auto& argument : view)
+        {
+            if (argument.isString())
+                checksum += static_cast<int>(argument.getString().size());
+            else if (argument.isInt32())
+                checksum += argument.getInt32();
+            else if (argument.isFloat32())
+                checksum += static_cast<int>(argument.getFloat32());
+        }
+
+        return checksum;
+    }
+
+    struct Packet
+    {
+        const char* name;
+        juce::MemoryBlock bytes;
+    };
+
+    Packet makeTagList()
+    {
+        char buffer[1024];
+        OSCPacketWriter writer(buffer, sizeof(buffer));
+        writer.writeString("/server/tags");
+        writer.writeString(",ssssssss");
+
+        for (auto* tag : { "piano", "strings_section_a", "violins_1", "violins_2", "violas", "celli", "basses", "brass_ensemble" })
+            writer.writeString(tag);
+
+        return { "tag list (8 strings)", juce::MemoryBlock(writer.getData(), writer.getSize()) };
+    }
+
+    Packet makeNumeric()
+    {
+        char buffer[1024];
+        OSCPacketWriter writer(buffer, sizeof(buffer));
+        writer.writeString("/server/levels");
+        writer.writeString(",iiiiffff");
+
+        for (int i = 0; i < 4; ++i)
+            writer.writeInt32(i * 1000);
+
+        for (int i = 0; i < 4; ++i)
+            writer.writeFloat32(0.25f * (float) i);
+
+        return { "numeric (4 int, 4 float)", juce::MemoryBlock(writer.getData(), writer.getSize()) };
+    }
+
+    Packet makeAcknowledgement()
+    {
+        char buffer[1024];
+        OSCPacketWriter writer(buffer, sizeof(buffer));
+        writer.writeString("/client/tags_ack");
+        writer.writeString(",ii");
+        writer.writeInt32(12345);
+        writer.writeInt32(7);
+
+        return { "tags_ack (2 int)", juce::MemoryBlock(writer.getData(), writer.getSize()) };
+    }
+
+    struct Result
+    {
+        double nsPerMessage;
+        double allocationsPerMessage;
+    };
+
+    template <typename Parser>
+    Result measure(const juce::MemoryBlock& packet, Parser&& parse)
+    {
+        const auto* data = static_cast<const char*>(packet.getData());
+        const auto size = packet.getSize();
+        volatile int sink = 0;
+
+        const auto allocationsBefore = allocationCount.load();
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numMessages; ++i)
+            sink = sink + parse(data, size);
+
+        const auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        const auto allocations = allocationCount.load() - allocationsBefore;
+
+        return { elapsed * 1.0e9 / numMessages, (double) allocations / numMessages };
+    }
+}
+
+int main()
+{
+    std::printf("OSC parser benchmark: %d messages per run\n\n", numMessages);
+    std::printf("%-26s %14s %12s %14s %12s\n", "message", "legacy ns", "legacy allocs", "view ns", "view allocs");
+
+    for (const auto& packet : { makeTagList(), makeNumeric(), makeAcknowledgement() })
+    {
+        const auto legacy = measure(packet.bytes, Legacy::parse);
+        const auto view = measure(packet.bytes, parseWithView);
+
+        std::printf("%-26s %14.1f %12.2f %14.1f %12.2f\n", packet.name,
+                    legacy.nsPerMessage, legacy.allocationsPerMessage,
+                    view.nsPerMessage, view.allocationsPerMessage);
+    }
+
+    return 0;
+}
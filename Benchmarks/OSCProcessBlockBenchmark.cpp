@@ -0,0 +1,487 @@
+/*
+  ==============================================================================
+
+    OSCProcessBlockBenchmark.cpp
+    Times OSC_ClientAudioProcessor::processBlock headlessly under synthetic
+    MIDI workloads.
+
+    Builds with the CMake project (target OSC_ClientProcessBlockBenchmark),
+    which links the plugin's shared code. For every workload, block size and
+    sample rate it feeds generated MIDI through processBlock as fast as it
+    can and reports the mean, p99 and worst time per block, the share of
+    the block's real-time budget the mean uses, and the events processed
+    per second of processBlock time. Events go to a UDP sink on localhost
+    that stands in for the server, so the transport thread does its real
+    work and nothing external is needed.
+
+        OSC_ClientProcessBlockBenchmark [--workload chords|cc|mpe|all]
+                                        [--blocks 64,128,...] [--rates 44100,48000,...]
+                                        [--instances 1,8,...] [--seconds N]
+                                        [--bundle] [--raw] [--latency] [--receive]
+
+    --instances runs that many processors side by side, as a session would,
+    each getting every block in turn. --latency paces the blocks in real
+    time, as a host would, and turns on latency probes (OSCLatency.h): the
+    sink then also reports p50, p99, p99.9 and worst time from processBlock
+    to arrival, overall and per instance. --receive turns on "MIDI in" and
+    has the sink send every datagram straight back, as raw MIDI, so
+    processBlock also renders the server's MIDI into its output buffer.
+
+    Configured with -DOSC_CLIENT_REALTIME_CHECKS=ON it also records every
+    allocation and blocking call made inside processBlock (see
+    RealtimeChecker.h), prints where they came from and exits with a
+    failure if there were any.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <vector>
+#include <map>
+#include <memory>
+#include "../Source/OSCLatency.h"
+#include "../Source/PluginProcessor.h"
+
+namespace
+{
+    //==============================================================================
+    struct Latencies
+    {
+        OSCLatencyHistogram overall;
+        std::map<juce::int32, OSCLatencyHistogram> perInstance;
+    };
+
+    // Counts what the processor sends, in place of the server, and times any
+    // latency probes on arrival
+    class UdpSink : private juce::Thread
+    {
+    public:
+        explicit UdpSink(bool shouldEcho) : juce::Thread("UDP Sink"), echo(shouldEcho)
+        {
+            if (socket.bindToPort(0, "127.0.0.1"))
+                startThread();
+        }
+
+        ~UdpSink() override  { stopThread(1000); }
+
+        int getPort() const                 { return socket.getBoundPort(); }
+        juce::uint64 getNumPackets() const  { return numPackets; }
+        juce::uint64 getNumBytes() const    { return numBytes; }
+
+        // The latencies recorded since the last call
+        Latencies takeLatencies()
+        {
+            const juce::ScopedLock sl(latencyLock);
+            auto taken = std::move(latencies);
+            latencies = {};
+            return taken;
+        }
+
+    private:
+        void run() override
+        {
+            juce::HeapBlock<char> buffer(65536);
+
+            while (!threadShouldExit())
+            {
+                if (socket.waitUntilReady(true, 100) <= 0)
+                    continue;
+
+                for (;;)
+                {
+                    juce::String senderAddress;
+                    int senderPort = 0;
+                    const auto size = socket.read(buffer.getData(), 65536, false, senderAddress, senderPort);
+
+                    if (size <= 0)
+                        break;
+
+                    // Raw MIDI messages carry the same layout in both directions
+                    if (echo)
+                        socket.write(senderAddress, senderPort, buffer.getData(), size);
+
+                    const auto arrivalMicros = OSCLatencyProbe::nowMicros();
+                    ++numPackets;
+                    numBytes += static_cast<juce::uint64>(size);
+
+                    const juce::ScopedLock sl(latencyLock);
+
+                    OSCParser::forEachMessage(buffer.getData(), static_cast<size_t>(size), [&](const OSCMessageView& message, juce::uint64)
+                    {
+                        OSCLatencyProbe probe;
+
+                        if (OSCLatencyProbe::read(message, probe))
+                        {
+                            latencies.overall.record(probe.getAgeMicros(arrivalMicros));
+                            latencies.perInstance[probe.instanceId].record(probe.getAgeMicros(arrivalMicros));
+                        }
+                    });
+                }
+            }
+        }
+
+        juce::DatagramSocket socket;
+        const bool echo;
+        std::atomic<juce::uint64> numPackets { 0 }, numBytes { 0 };
+
+        juce::CriticalSection latencyLock;
+        Latencies latencies;
+    };
+
+    //==============================================================================
+    enum class Workload { chords, controllerSweep, mpe };
+
+    const char* getName(Workload workload)
+    {
+        switch (workload)
+        {
+            case Workload::chords:           return "chords";
+            case Workload::controllerSweep:  return "cc";
+            case Workload::mpe:              return "mpe";
+        }
+
+        return "";
+    }
+
+    // Calls fn(sampleInBlock, tick) for every tick of a periodic event that
+    // falls in [blockStart, blockStart + numSamples)
+    template <typename Fn>
+    void forEachTick(juce::int64 blockStart, int numSamples, double periodSamples, double offsetSamples, Fn&& fn)
+    {
+        auto tick = static_cast<juce::int64>(std::ceil((static_cast<double>(blockStart) - offsetSamples) / periodSamples));
+        tick = juce::jmax<juce::int64>(0, tick);
+
+        for (;; ++tick)
+        {
+            const auto position = static_cast<juce::int64>(offsetSamples + static_cast<double>(tick) * periodSamples);
+
+            if (position >= blockStart + numSamples)
+                break;
+
+            if (position >= blockStart)
+                fn(static_cast<int>(position - blockStart), tick);
+        }
+    }
+
+    // Fills midi with the workload's events for one block
+    void generate(Workload workload, juce::int64 blockStart, int numSamples, double sampleRate, juce::MidiBuffer& midi)
+    {
+        const auto ms = sampleRate / 1000.0;
+
+        switch (workload)
+        {
+            // Eight-note chords struck every 100 ms and released 50 ms later
+            case Workload::chords:
+                forEachTick(blockStart, numSamples, 100.0 * ms, 0.0, [&](int position, juce::int64 tick)
+                {
+                    for (int i = 0; i < 8; ++i)
+                        midi.addEvent(juce::MidiMessage::noteOn(1, 48 + (int) (tick % 12) + i * 3, (juce::uint8) 100), position);
+                });
+
+                forEachTick(blockStart, numSamples, 100.0 * ms, 50.0 * ms, [&](int position, juce::int64 tick)
+                {
+                    for (int i = 0; i < 8; ++i)
+                        midi.addEvent(juce::MidiMessage::noteOff(1, 48 + (int) (tick % 12) + i * 3), position);
+                });
+                break;
+
+            // Four controllers swept together, one step per millisecond
+            case Workload::controllerSweep:
+                forEachTick(blockStart, numSamples, ms, 0.0, [&](int position, juce::int64 tick)
+                {
+                    for (auto controller : { 1, 7, 11, 74 })
+                        midi.addEvent(juce::MidiMessage::controllerEvent(1, controller, (int) ((tick + controller) % 128)), position);
+                });
+                break;
+
+            // MPE: a note on each of 16 channels every 200 ms, staggered, with
+            // pitch bend, slide (CC74) and pressure every 2 ms while it sounds
+            case Workload::mpe:
+                for (int channel = 1; channel <= 16; ++channel)
+                {
+                    const auto offset = (channel - 1) * 12.5 * ms;
+
+                    forEachTick(blockStart, numSamples, 200.0 * ms, offset, [&](int position, juce::int64 tick)
+                    {
+                        midi.addEvent(juce::MidiMessage::noteOn(channel, 40 + channel + (int) (tick % 5), (juce::uint8) 90), position);
+                    });
+
+                    forEachTick(blockStart, numSamples, 200.0 * ms, offset + 150.0 * ms, [&](int position, juce::int64 tick)
+                    {
+                        midi.addEvent(juce::MidiMessage::noteOff(channel, 40 + channel + (int) (tick % 5)), position);
+                    });
+
+                    forEachTick(blockStart, numSamples, 2.0 * ms, offset, [&](int position, juce::int64 tick)
+                    {
+                        if (std::fmod(static_cast<double>(tick) * 2.0, 200.0) >= 150.0)
+                            return;
+
+                        midi.addEvent(juce::MidiMessage::pitchWheel(channel, 8192 + (int) ((tick * 37) % 2048) - 1024), position);
+                        midi.addEvent(juce::MidiMessage::controllerEvent(channel, 74, (int) (tick % 128)), position);
+                        midi.addEvent(juce::MidiMessage::channelPressureChange(channel, (int) ((tick * 3) % 128)), position);
+                    });
+                }
+                break;
+        }
+    }
+
+    //==============================================================================
+    struct Options
+    {
+        std::vector<Workload> workloads { Workload::chords, Workload::controllerSweep, Workload::mpe };
+        std::vector<int> blockSizes { 64, 128, 256, 512, 1024 };
+        std::vector<double> sampleRates { 44100.0, 48000.0, 96000.0 };
+        std::vector<int> instanceCounts { 1 };
+        double seconds = 5.0;
+        bool bundle = false;
+        bool rawMidi = false;
+        bool latency = false;
+        bool receive = false;
+    };
+
+    Options parseOptions(const juce::ArgumentList& args)
+    {
+        Options options;
+
+        if (args.containsOption("--workload"))
+        {
+            const auto name = args.getValueForOption("--workload");
+
+            if (name == "chords")  options.workloads = { Workload::chords };
+            if (name == "cc")      options.workloads = { Workload::controllerSweep };
+            if (name == "mpe")     options.workloads = { Workload::mpe };
+        }
+
+        if (args.containsOption("--blocks"))
+        {
+            options.blockSizes.clear();
+
+            for (const auto& size : juce::StringArray::fromTokens(args.getValueForOption("--blocks"), ",", {}))
+                if (size.getIntValue() > 0)
+                    options.blockSizes.push_back(size.getIntValue());
+        }
+
+        if (args.containsOption("--rates"))
+        {
+            options.sampleRates.clear();
+
+            for (const auto& rate : juce::StringArray::fromTokens(args.getValueForOption("--rates"), ",", {}))
+                if (rate.getDoubleValue() > 0.0)
+                    options.sampleRates.push_back(rate.getDoubleValue());
+        }
+
+        if (args.containsOption("--instances"))
+        {
+            options.instanceCounts.clear();
+
+            for (const auto& count : juce::StringArray::fromTokens(args.getValueForOption("--instances"), ",", {}))
+                if (count.getIntValue() > 0)
+                    options.instanceCounts.push_back(count.getIntValue());
+        }
+
+        if (args.containsOption("--seconds"))
+            options.seconds = juce::jmax(0.1, args.getValueForOption("--seconds").getDoubleValue());
+
+        options.bundle = args.containsOption("--bundle");
+        options.rawMidi = args.containsOption("--raw");
+        options.latency = args.containsOption("--latency");
+        options.receive = args.containsOption("--receive");
+
+        // Only raw MIDI replies are played; probes would make them look like extra tags
+        if (options.receive)
+        {
+            options.rawMidi = true;
+            options.latency = false;
+        }
+        return options;
+    }
+
+    struct Result
+    {
+        double meanUs = 0.0, p99Us = 0.0, worstUs = 0.0;
+        double budgetPercent = 0.0;
+        double eventsPerSecond = 0.0;
+    };
+
+    // Like a host's audio callback: wait for the block's start time
+    void waitUntil(double targetSeconds)
+    {
+        for (;;)
+        {
+            const auto remainingMs = 1000.0 * (targetSeconds - juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks()));
+
+            if (remainingMs <= 0.0)
+                return;
+
+            if (remainingMs > 2.0)
+                juce::Thread::sleep(1);
+            else
+                juce::Thread::yield();
+        }
+    }
+
+    Result run(std::vector<std::unique_ptr<OSC_ClientAudioProcessor>>& processors, Workload workload,
+               int blockSize, double sampleRate, double seconds, bool realtime)
+    {
+        for (auto& processor : processors)
+            processor->prepareToPlay(sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midi, instanceMidi;
+        midi.ensureSize(8192);
+        instanceMidi.ensureSize(8192);
+
+        const auto numBlocks = juce::jmax(1, static_cast<int>(seconds * sampleRate / blockSize));
+        const auto numCalls = numBlocks * static_cast<int>(processors.size());
+        std::vector<double> blockUs;
+        blockUs.reserve(static_cast<size_t>(numCalls));
+        juce::uint64 numEvents = 0;
+
+        const auto startSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks());
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            if (realtime)
+                waitUntil(startSeconds + static_cast<double>(block) * blockSize / sampleRate);
+
+            midi.clear();
+            generate(workload, static_cast<juce::int64>(block) * blockSize, blockSize, sampleRate, midi);
+
+            for (auto& processor : processors)
+            {
+                instanceMidi.clear();
+                instanceMidi.addEvents(midi, 0, -1, 0);
+                numEvents += static_cast<juce::uint64>(instanceMidi.getNumEvents());
+
+                const auto start = juce::Time::getHighResolutionTicks();
+                processor->processBlock(buffer, instanceMidi);
+                blockUs.push_back(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1.0e6);
+            }
+        }
+
+        for (auto& processor : processors)
+            processor->releaseResources();
+
+        Result result;
+        double totalUs = 0.0;
+
+        for (auto us : blockUs)
+            totalUs += us;
+
+        std::sort(blockUs.begin(), blockUs.end());
+        result.meanUs = totalUs / numCalls;
+        result.p99Us = blockUs[static_cast<size_t>(0.99 * (numCalls - 1))];
+        result.worstUs = blockUs.back();
+        result.budgetPercent = 100.0 * result.meanUs / (1.0e6 * blockSize / sampleRate);
+        result.eventsPerSecond = totalUs > 0.0 ? static_cast<double>(numEvents) / (totalUs / 1.0e6) : 0.0;
+        return result;
+    }
+
+    void printLatency(const char* label, const OSCLatencyHistogram& histogram)
+    {
+        std::printf("    %-14s %9llu %9u %9u %9u %9u\n", label, (unsigned long long) histogram.getCount(),
+                    histogram.getPercentile(50.0), histogram.getPercentile(99.0),
+                    histogram.getPercentile(99.9), histogram.getMax());
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const auto options = parseOptions(juce::ArgumentList(argc, argv));
+
+    UdpSink sink(options.receive);
+
+    std::printf("processBlock benchmark: %.1f s of audio per run, %s, %s%s%s, sink on port %d\n\n",
+                options.seconds, options.bundle ? "bundled" : "unbundled",
+                options.rawMidi ? "raw MIDI" : "string messages",
+                options.latency ? ", paced in real time with latency probes" : "",
+                options.receive ? ", echoed back as MIDI in" : "", sink.getPort());
+    std::printf("%-8s %9s %7s %8s %10s %10s %10s %9s %14s\n",
+                "workload", "instances", "block", "rate", "mean us", "p99 us", "worst us", "budget %", "events/s");
+
+    for (auto numInstances : options.instanceCounts)
+    {
+        std::vector<std::unique_ptr<OSC_ClientAudioProcessor>> processors;
+
+        for (int i = 0; i < numInstances; ++i)
+        {
+            auto processor = std::make_unique<OSC_ClientAudioProcessor>();
+            processor->setIpAddress("127.0.0.1");
+            processor->setPort(sink.getPort());
+            processor->reConnect();
+            processor->setBundleEvents(options.bundle);
+            processor->setWireFormat(options.rawMidi ? OSCWireFormat::midi : OSCWireFormat::strings);
+            processor->setLatencyProbes(options.latency);
+            processor->setReceiveMidi(options.receive);
+            processors.push_back(std::move(processor));
+        }
+
+        for (auto workload : options.workloads)
+        {
+            for (auto sampleRate : options.sampleRates)
+            {
+                for (auto blockSize : options.blockSizes)
+                {
+                    sink.takeLatencies();
+                    const auto result = run(processors, workload, blockSize, sampleRate, options.seconds, options.latency);
+
+                    std::printf("%-8s %9d %7d %8.0f %10.2f %10.2f %10.2f %9.3f %14.0f\n",
+                                getName(workload), numInstances, blockSize, sampleRate,
+                                result.meanUs, result.p99Us, result.worstUs,
+                                result.budgetPercent, result.eventsPerSecond);
+
+                    if (options.latency)
+                    {
+                        // Let the last events arrive
+                        juce::Thread::sleep(100);
+                        const auto latencies = sink.takeLatencies();
+
+                        std::printf("    %-14s %9s %9s %9s %9s %9s\n", "latency us", "events", "p50", "p99", "p99.9", "max");
+                        printLatency("all instances", latencies.overall);
+
+                        if (latencies.perInstance.size() > 1)
+                            for (const auto& [id, histogram] : latencies.perInstance)
+                                printLatency(("instance " + juce::String(id)).toRawUTF8(), histogram);
+                    }
+                }
+            }
+        }
+
+        // Let the transport thread drain what is still queued before counting
+        juce::Thread::sleep(200);
+
+        if (options.receive)
+        {
+            OSC_ClientAudioProcessor::IncomingMidiStats total;
+
+            for (const auto& processor : processors)
+            {
+                const auto stats = processor->getIncomingMidiStats();
+                total.numReceived += stats.numReceived;
+                total.numLate += stats.numLate;
+                total.numHeldForCapacity += stats.numHeldForCapacity;
+                total.numDropped += stats.numDropped;
+            }
+
+            std::printf("    MIDI in: %llu received, %llu late, %llu held for buffer room, %llu dropped\n",
+                        (unsigned long long) total.numReceived, (unsigned long long) total.numLate,
+                        (unsigned long long) total.numHeldForCapacity, (unsigned long long) total.numDropped);
+        }
+    }
+
+    std::printf("\nsink received %llu packets, %llu bytes\n",
+                (unsigned long long) sink.getNumPackets(), (unsigned long long) sink.getNumBytes());
+
+   #if OSC_CLIENT_REALTIME_CHECKS
+    std::fflush(stdout);
+
+    if (RealtimeChecker::report() > 0)
+        return 1;
+   #endif
+
+    return 0;
+}
@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    OSCStartupBenchmark.cpp
+    Session-load cost of 500 plugin instances: socket setup in every
+    constructor versus the shared hub with deferred setup.
+
+    The legacy path is what each OSC_ClientAudioProcessor used to do on the
+    host's loading thread: bind a send socket, then bind a multicast socket
+    and join the group. The new path is what the constructor does now:
+    take a reference to the shared OSCTransportHub, allocate its event queue
+    and register as a client; the hub's threads bind and join in the
+    background. Reports the total construction time, the worst single
+    constructor and, for the hub, how long until the multicast group was
+    joined.
+
+    The instances here stand in for the processor (which needs the audio
+    modules); they do the same socket and hub work as its constructor.
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include "../Source/OSCTransportHub.h"
+
+namespace
+{
+    constexpr int numInstances = 500;
+    constexpr int multicastPort = 9000;
+    const char* const multicastGroup = "239.255.0.1";
+
+    struct LegacyInstance
+    {
+        LegacyInstance()
+        {
+            sendSocket.bindToPort(0);
+
+            multicastSocket.setEnablePortReuse(true);
+
+            if (multicastSocket.bindToPort(multicastPort))
+                multicastSocket.joinMulticast(multicastGroup);
+        }
+
+        ~LegacyInstance()
+        {
+            multicastSocket.leaveMulticast(multicastGroup);
+        }
+
+        juce::DatagramSocket sendSocket;
+        juce::DatagramSocket multicastSocket;
+    };
+
+    struct HubInstance : private OSCTransportHub::Client
+    {
+        HubInstance()    { transportHub->addClient(*this); }
+        ~HubInstance()   { transportHub->removeClient(*this); }
+
+        int serviceTransport(OSCTransportHub&, double) override
+        {
+            return eventQueue.popAll([](const OSCEvent&) {});
+        }
+
+        void handleServerReply(const OSCTransportHub::Destination&, const char*, int, double) override {}
+        bool usesAutoConnect() override  { return false; }
+
+        juce::SharedResourcePointer<OSCTransportHub> transportHub;
+        OSCEventQueue eventQueue { 4096 };
+    };
+
+    struct Result
+    {
+        double totalMs = 0.0;
+        double worstMs = 0.0;
+    };
+
+    template <typename Instance>
+    Result construct(std::vector<std::unique_ptr<Instance>>& instances)
+    {
+        Result result;
+
+        for (int i = 0; i < numInstances; ++i)
+        {
+            const auto start = juce::Time::getMillisecondCounterHiRes();
+            instances.push_back(std::make_unique<Instance>());
+            const auto elapsed = juce::Time::getMillisecondCounterHiRes() - start;
+
+            result.totalMs += elapsed;
+            result.worstMs = juce::jmax(result.worstMs, elapsed);
+        }
+
+        return result;
+    }
+}
+
+int main()
+{
+    std::printf("OSC startup benchmark: %d instances\n\n", numInstances);
+    std::printf("%-24s %12s %12s %14s\n", "", "total ms", "worst ms", "joined after ms");
+
+    {
+        std::vector<std::unique_ptr<LegacyInstance>> instances;
+        const auto result = construct(instances);
+        std::printf("%-24s %12.2f %12.3f %14s\n", "socket per instance", result.totalMs, result.worstMs, "-");
+    }
+
+    {
+        std::vector<std::unique_ptr<HubInstance>> instances;
+        const auto start = juce::Time::getMillisecondCounterHiRes();
+        const auto result = construct(instances);
+
+        auto& receiver = instances.front()->transportHub->getMulticastReceiver();
+
+        while (!receiver.isJoined() && juce::Time::getMillisecondCounterHiRes() - start < 5000.0)
+            juce::Thread::sleep(1);
+
+        const auto joinedMs = juce::Time::getMillisecondCounterHiRes() - start;
+        std::printf("%-24s %12.2f %12.3f %14.2f\n", "shared hub, deferred", result.totalMs, result.worstMs, joinedMs);
+    }
+
+    return 0;
+}
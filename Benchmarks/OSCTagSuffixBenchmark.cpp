@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    OSCTagSuffixBenchmark.cpp
+    Per-event tag encoding versus the precomputed OSCTagSuffix.
+
+    The per-event path writes every tag as an OSC-string for each message,
+    as sendOscMessage used to with addString. The suffix path copies the
+    bytes OSCTagSuffix::fromTags prepared once. Both are measured for a
+    range of tag counts with realistic instrument names.
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include <cstdio>
+#include "../Source/OSCEncoder.h"
+
+namespace
+{
+    constexpr int numEvents = 500000;
+
+    juce::StringArray makeTags(int numTags)
+    {
+        juce::StringArray tags;
+
+        for (int i = 0; i < numTags; ++i)
+            tags.add("orchestra/strings/violins_" + juce::String(i + 1) + "_sustain_legato");
+
+        return tags;
+    }
+
+    // The encoding used before the suffix was cached: tags written one by one
+    void writeEventWithTags(OSCPacketWriter& writer, const OSCEvent& event, const juce::StringArray& tags)
+    {
+        writer.writeString("/midi/message", 13);
+
+        char typeTagString[256] = ",siit";
+        const auto numTypeTags = juce::jmin(tags.size(), (int) sizeof(typeTagString) - 6);
+
+        for (int i = 0; i < numTypeTags; ++i)
+            typeTagString[5 + i] = 's';
+
+        writer.writeString(typeTagString, (size_t) (5 + numTypeTags));
+        writer.writeString("note_on", 7);
+        writer.writeInt32(event.data1);
+        writer.writeInt32(event.data2);
+        writer.writeTimeTag(event.timeTag);
+
+        for (const auto& tag : tags)
+            writer.writeString(tag);
+    }
+
+    template <typename Body>
+    double measureNsPerEvent(Body&& body)
+    {
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numEvents; ++i)
+            body();
+
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1.0e9 / numEvents;
+    }
+}
+
+int main()
+{
+    juce::HeapBlock<char> buffer(OSCEventEncoder::maxPacketSize);
+    OSCPacketWriter writer(buffer.getData(), OSCEventEncoder::maxPacketSize);
+
+    OSCEvent event;
+    event.status = 0x90;
+    event.data1 = 60;
+    event.data2 = 100;
+
+    std::printf("Tag suffix benchmark: %d note-on events per run\n\n", numEvents);
+    std::printf("%6s %16s %16s %10s\n", "tags", "per-event ns", "suffix ns", "speed-up");
+
+    for (auto numTags : { 1, 4, 16, 64, 200 })
+    {
+        const auto tags = makeTags(numTags);
+        const auto suffix = OSCTagSuffix::fromTags(tags);
+
+        const auto perEventNs = measureNsPerEvent([&]
+        {
+            writer.reset();
+            writeEventWithTags(writer, event, tags);
+        });
+
+        const auto suffixNs = measureNsPerEvent([&]
+        {
+            writer.reset();
+            OSCEventEncoder::writeEvent(writer, event, suffix);
+        });
+
+        std::printf("%6d %16.1f %16.1f %9.1fx\n", numTags, perEventNs, suffixNs, perEventNs / suffixNs);
+    }
+
+    return 0;
+}
@@ -0,0 +1,386 @@
+/*
+  ==============================================================================
+
+    RealtimeChecker.cpp
+    The interposers behind RealtimeChecker.h, for checked benchmark and test
+    builds on Linux (glibc).
+
+    Linking this file into an executable replaces the C allocator entry
+    points (which operator new and delete go through) and wraps the socket,
+    mutex, condition variable and sleep calls the plugin could reach. Each
+    wrapper checks whether the calling thread is inside a
+    RealtimeChecker::ScopedSection; if it is, the call stack is recorded
+    before the call goes ahead as usual. Nothing here allocates or locks
+    while recording, so the checker does not disturb the thread it watches
+    any more than the offending call already did.
+
+    Never link this into the plugin itself.
+
+  ==============================================================================
+*/
+
+#include "../Source/RealtimeChecker.h"
+
+#if ! OSC_CLIENT_REALTIME_CHECKS
+ #error "Build with OSC_CLIENT_REALTIME_CHECKS=1 when linking the real-time checker"
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <poll.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#if ! defined (__linux__) || ! defined (__GLIBC__)
+ #error "The real-time checker interposes glibc functions and only supports Linux"
+#endif
+
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+}
+
+namespace
+{
+    constexpr int maxFrames = 32;
+    constexpr int maxSites = 64;
+    constexpr int framesToSkip = 2;     // record() and the interposer
+
+    struct Site
+    {
+        std::uint64_t hash;
+        const char* function;
+        int numFrames;
+        void* frames[maxFrames];
+        int count;
+    };
+
+    // Static storage only: recording must not allocate
+    Site sites[maxSites];
+    int numSites = 0;
+    std::atomic_flag sitesLock = ATOMIC_FLAG_INIT;
+    std::atomic<int> numViolations { 0 };
+    std::atomic<int> numUnrecordedSites { 0 };
+
+    thread_local int sectionDepth = 0;
+    thread_local bool recording = false;
+
+    void record(const char* function) noexcept
+    {
+        if (sectionDepth == 0 || recording)
+            return;
+
+        // Anything the recording itself calls passes straight through
+        recording = true;
+        numViolations.fetch_add(1, std::memory_order_relaxed);
+
+        void* frames[maxFrames];
+        const auto numFrames = backtrace(frames, maxFrames);
+
+        std::uint64_t hash = 14695981039346656037ull;
+
+        auto mix = [&hash](std::uintptr_t value)
+        {
+            hash = (hash ^ value) * 1099511628211ull;
+        };
+
+        mix(reinterpret_cast<std::uintptr_t>(function));
+
+        for (int i = framesToSkip; i < numFrames; ++i)
+            mix(reinterpret_cast<std::uintptr_t>(frames[i]));
+
+        while (sitesLock.test_and_set(std::memory_order_acquire)) {}
+
+        bool found = false;
+
+        for (int i = 0; i < numSites && !found; ++i)
+        {
+            if (sites[i].hash == hash)
+            {
+                ++sites[i].count;
+                found = true;
+            }
+        }
+
+        if (!found)
+        {
+            if (numSites < maxSites)
+            {
+                auto& site = sites[numSites++];
+                site.hash = hash;
+                site.function = function;
+                site.numFrames = numFrames;
+                std::memcpy(site.frames, frames, sizeof(void*) * static_cast<size_t>(numFrames));
+                site.count = 1;
+            }
+            else
+            {
+                numUnrecordedSites.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        sitesLock.clear(std::memory_order_release);
+        recording = false;
+    }
+
+    // The next definition of a wrapped function, looked up once
+    template <typename Function>
+    Function next(Function& slot, const char* name) noexcept
+    {
+        if (slot == nullptr)
+            slot = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+
+        return slot;
+    }
+
+    decltype(&::send) nextSend;
+    decltype(&::sendto) nextSendTo;
+    decltype(&::sendmsg) nextSendMsg;
+    decltype(&::recv) nextRecv;
+    decltype(&::recvfrom) nextRecvFrom;
+    decltype(&::recvmsg) nextRecvMsg;
+    decltype(&::connect) nextConnect;
+    decltype(&::poll) nextPoll;
+    decltype(&::select) nextSelect;
+    decltype(&::pthread_mutex_lock) nextMutexLock;
+    decltype(&::pthread_cond_wait) nextCondWait;
+    decltype(&::pthread_cond_timedwait) nextCondTimedWait;
+    decltype(&::pthread_rwlock_rdlock) nextReadLock;
+    decltype(&::pthread_rwlock_wrlock) nextWriteLock;
+    decltype(&::sem_wait) nextSemWait;
+    decltype(&::nanosleep) nextNanosleep;
+    decltype(&::usleep) nextUsleep;
+
+    // Resolves everything and loads the unwinder before main, so that
+    // neither happens (and allocates) for the first time inside a section
+    __attribute__((constructor)) void initialise()
+    {
+        void* frames[4];
+        backtrace(frames, 4);
+
+        next(nextSend, "send");
+        next(nextSendTo, "sendto");
+        next(nextSendMsg, "sendmsg");
+        next(nextRecv, "recv");
+        next(nextRecvFrom, "recvfrom");
+        next(nextRecvMsg, "recvmsg");
+        next(nextConnect, "connect");
+        next(nextPoll, "poll");
+        next(nextSelect, "select");
+        next(nextMutexLock, "pthread_mutex_lock");
+        next(nextCondWait, "pthread_cond_wait");
+        next(nextCondTimedWait, "pthread_cond_timedwait");
+        next(nextReadLock, "pthread_rwlock_rdlock");
+        next(nextWriteLock, "pthread_rwlock_wrlock");
+        next(nextSemWait, "sem_wait");
+        next(nextNanosleep, "nanosleep");
+        next(nextUsleep, "usleep");
+    }
+}
+
+//==============================================================================
+void RealtimeChecker::enterSection() noexcept  { ++sectionDepth; }
+void RealtimeChecker::exitSection() noexcept   { --sectionDepth; }
+
+int RealtimeChecker::report()
+{
+    const auto total = numViolations.load();
+
+    if (total == 0)
+    {
+        std::fprintf(stderr, "Real-time check: no allocations or blocking calls\n");
+        return 0;
+    }
+
+    std::fprintf(stderr, "Real-time check: %d violation(s) at %d call site(s)\n", total, numSites);
+
+    for (int i = 0; i < numSites; ++i)
+    {
+        const auto& site = sites[i];
+        std::fprintf(stderr, "\n%s called %d time(s) from:\n", site.function, site.count);
+        std::fflush(stderr);
+
+        if (site.numFrames > framesToSkip)
+            backtrace_symbols_fd(site.frames + framesToSkip, site.numFrames - framesToSkip, STDERR_FILENO);
+    }
+
+    if (numUnrecordedSites.load() > 0)
+        std::fprintf(stderr, "\n(%d more call site(s) not recorded)\n", numUnrecordedSites.load());
+
+    return total;
+}
+
+//==============================================================================
+extern "C"
+{
+    void* malloc(size_t size)
+    {
+        record("malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        record("calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size)
+    {
+        record("realloc");
+        return __libc_realloc(pointer, size);
+    }
+
+    void free(void* pointer)
+    {
+        if (pointer != nullptr)
+            record("free");
+
+        __libc_free(pointer);
+    }
+
+    void* memalign(size_t alignment, size_t size)
+    {
+        record("memalign");
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        record("aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size)
+    {
+        record("posix_memalign");
+
+        if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        auto* pointer = __libc_memalign(alignment, size);
+
+        if (pointer == nullptr)
+            return ENOMEM;
+
+        *result = pointer;
+        return 0;
+    }
+
+    //==============================================================================
+    ssize_t send(int socket, const void* data, size_t size, int flags)
+    {
+        record("send");
+        return next(nextSend, "send")(socket, data, size, flags);
+    }
+
+    ssize_t sendto(int socket, const void* data, size_t size, int flags, const sockaddr* address, socklen_t addressSize)
+    {
+        record("sendto");
+        return next(nextSendTo, "sendto")(socket, data, size, flags, address, addressSize);
+    }
+
+    ssize_t sendmsg(int socket, const msghdr* message, int flags)
+    {
+        record("sendmsg");
+        return next(nextSendMsg, "sendmsg")(socket, message, flags);
+    }
+
+    ssize_t recv(int socket, void* data, size_t size, int flags)
+    {
+        record("recv");
+        return next(nextRecv, "recv")(socket, data, size, flags);
+    }
+
+    ssize_t recvfrom(int socket, void* data, size_t size, int flags, sockaddr* address, socklen_t* addressSize)
+    {
+        record("recvfrom");
+        return next(nextRecvFrom, "recvfrom")(socket, data, size, flags, address, addressSize);
+    }
+
+    ssize_t recvmsg(int socket, msghdr* message, int flags)
+    {
+        record("recvmsg");
+        return next(nextRecvMsg, "recvmsg")(socket, message, flags);
+    }
+
+    int connect(int socket, const sockaddr* address, socklen_t addressSize)
+    {
+        record("connect");
+        return next(nextConnect, "connect")(socket, address, addressSize);
+    }
+
+    int poll(pollfd* fds, nfds_t numFds, int timeoutMs)
+    {
+        record("poll");
+        return next(nextPoll, "poll")(fds, numFds, timeoutMs);
+    }
+
+    int select(int numFds, fd_set* readFds, fd_set* writeFds, fd_set* errorFds, timeval* timeout)
+    {
+        record("select");
+        return next(nextSelect, "select")(numFds, readFds, writeFds, errorFds, timeout);
+    }
+
+    //==============================================================================
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        record("pthread_mutex_lock");
+        return next(nextMutexLock, "pthread_mutex_lock")(mutex);
+    }
+
+    int pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex)
+    {
+        record("pthread_cond_wait");
+        return next(nextCondWait, "pthread_cond_wait")(condition, mutex);
+    }
+
+    int pthread_cond_timedwait(pthread_cond_t* condition, pthread_mutex_t* mutex, const timespec* deadline)
+    {
+        record("pthread_cond_timedwait");
+        return next(nextCondTimedWait, "pthread_cond_timedwait")(condition, mutex, deadline);
+    }
+
+    int pthread_rwlock_rdlock(pthread_rwlock_t* lock)
+    {
+        record("pthread_rwlock_rdlock");
+        return next(nextReadLock, "pthread_rwlock_rdlock")(lock);
+    }
+
+    int pthread_rwlock_wrlock(pthread_rwlock_t* lock)
+    {
+        record("pthread_rwlock_wrlock");
+        return next(nextWriteLock, "pthread_rwlock_wrlock")(lock);
+    }
+
+    int sem_wait(sem_t* semaphore)
+    {
+        record("sem_wait");
+        return next(nextSemWait, "sem_wait")(semaphore);
+    }
+
+    int nanosleep(const timespec* duration, timespec* remaining)
+    {
+        record("nanosleep");
+        return next(nextNanosleep, "nanosleep")(duration, remaining);
+    }
+
+    int usleep(useconds_t microseconds)
+    {
+        record("usleep");
+        return next(nextUsleep, "usleep")(microseconds);
+    }
+}
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    OSCParserFuzzer.cpp
+    libFuzzer target for OSCMessageView and the bundle walker.
+
+    Build with clang and -fsanitize=fuzzer,address,undefined, then run it on
+    corpus/OSCParser. Defining OSC_FUZZ_STANDALONE instead gives a plain
+    executable that replays the files named on the command line, which is
+    handy for checking the corpus with any compiler.
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "../Source/OSCParser.h"
+
+namespace
+{
+    // Every accessor must stay within the datagram once parse() has accepted it
+    size_t readArguments(const OSCMessageView& view)
+    {
+        size_t checksum = view.getAddress().size() + view.getTypeTags().size();
+        int numArguments = 0;
+
+        for (const auto& argument : view)
+        {
+            ++numArguments;
+
+            switch (argument.type)
+            {
+                case 'i': case 'c': case 'r': checksum += static_cast<size_t>(argument.getInt32()); break;
+                case 'f':  checksum += static_cast<size_t>(argument.getFloat32() != 0.0f); break;
+                case 'h':  checksum += static_cast<size_t>(argument.getInt64()); break;
+                case 'd':  checksum += static_cast<size_t>(argument.getFloat64() != 0.0); break;
+                case 't':  checksum += static_cast<size_t>(argument.getTimeTag()); break;
+                case 'm':  checksum += argument.getMidi()[3]; break;
+                case 's': case 'S': checksum += argument.getString().size(); break;
+                case 'b':
+                    if (argument.getBlobSize() > 0)
+                        checksum += static_cast<size_t>(argument.getBlobData()[argument.getBlobSize() - 1]);
+                    break;
+                default:   break;
+            }
+        }
+
+        if (numArguments != view.getNumArguments())
+            __builtin_trap();
+
+        return checksum;
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const juce::uint8* data, size_t size)
+{
+    // Copy into an exactly-sized buffer so the sanitisers catch any overread
+    std::vector<char> buffer(data, data + size);
+    size_t checksum = 0;
+
+    OSCMessageView view;
+
+    if (view.parse(buffer.data(), buffer.size()))
+        checksum += readArguments(view);
+
+    // Bundles, recursively; a packet that validates must also walk cleanly
+    const auto isValid = OSCParser::validatePacket(buffer.data(), buffer.size());
+    const auto walked = OSCParser::forEachMessage(buffer.data(), buffer.size(), [&checksum](const OSCMessageView& message, juce::uint64 timeTag)
+    {
+        checksum += readArguments(message) + static_cast<size_t>(timeTag);
+    });
+
+    if (isValid != walked)
+        __builtin_trap();
+
+    return static_cast<int>(checksum & 0);
+}
+
+#ifdef OSC_FUZZ_STANDALONE
+int main(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::ifstream file(argv[i], std::ios::binary);
+
+        if (!file)
+        {
+            std::fprintf(stderr, "Cannot read %s\n", argv[i]);
+            return 1;
+        }
+
+        const std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        LLVMFuzzerTestOneInput(reinterpret_cast<const juce::uint8*>(contents.data()), contents.size());
+    }
+
+    std::printf("Replayed %d inputs\n", argc - 1);
+    return 0;
+}
+#endif
@@ -12,170 +12,534 @@
 
 #include <juce_core/juce_core.h>
 #include <juce_osc/juce_osc.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include "OSCAddressDispatcher.h"
+#include "OSCCatalogueCache.h"
+#include "OSCEncoder.h"
+#include "OSCLog.h"
+#include "OSCParser.h"
+#include "OSCTagCatalogue.h"
+#include "SnapshotPublisher.h"
 
-class OSCMulticastReceiver : public juce::OSCReceiver
+// A message received on the multicast group, copied out of the datagram
+struct ParsedOSCMessage
+{
+    juce::String addressPattern;
+    juce::Array<juce::var> arguments;
+    juce::uint64 timeTag = OSCParser::immediateTimeTag;
+};
+
+// The latest messages received for one address. If a packet carries several
+// messages for the same address (a catalogue split across a bundle) they are
+// kept together, in order.
+struct CachedOSCMessages
+{
+    juce::Array<ParsedOSCMessage> messages;
+    juce::uint64 version = 0;       // how many packets have updated this address
+    juce::uint64 packetNumber = 0;  // numPacketsReceived when last updated
+    double receivedAtMs = 0.0;
+};
+
+struct OSCAddressHash
+{
+    size_t operator()(const juce::String& address) const noexcept  { return static_cast<size_t>(address.hash()); }
+};
+
+// What readers see: the latest messages for each address, so a heartbeat
+// cannot hide the tag list that arrived before it, plus every message from
+// the last packet in order. A bundle is published as a whole, so a catalogue
+// split across its messages is never seen half-updated.
+struct MulticastState
+{
+    // Entries are shared between snapshots; only updated addresses are copied
+    using AddressCache = std::unordered_map<juce::String, std::shared_ptr<const CachedOSCMessages>, OSCAddressHash>;
+
+    AddressCache messagesByAddress;
+    juce::Array<ParsedOSCMessage> latestPacket;
+    OSCTagCatalogue catalogue;
+    juce::uint64 numPacketsReceived = 0;
+    double receivedAtMs = 0.0;
+
+    // O(1); nullptr if nothing has been received for the address
+    const CachedOSCMessages* find(const juce::String& address) const
+    {
+        const auto found = messagesByAddress.find(address);
+        return found != messagesByAddress.end() ? found->second.get() : nullptr;
+    }
+};
+
+// Receives the server's multicast announcements on its own thread. The thread
+// blocks on the socket, parses every datagram (up to the 64 KB UDP limit,
+// bundles included) as it arrives and publishes the result as an immutable
+// snapshot, so the kernel buffer never fills up and readers always get the
+// latest state without touching the socket.
+class OSCMulticastReceiver : private juce::Thread
 {
 public:
+    // Reader slots for the snapshot: one per thread that reads it
+    enum Reader
+    {
+        messageThreadReader,
+        transportThreadReader,
+        numReaders
+    };
+
+    using StatePublisher = SnapshotPublisher<MulticastState, numReaders>;
+
+    // Only starts the receive thread: reading the cached catalogue, binding
+    // and joining the group all happen there, so that constructing the hub
+    // never waits on the disk or the network stack
     OSCMulticastReceiver(const juce::String& multicastIP, int port)
-        : multicastAddress(multicastIP), multicastPort(port)
+        : juce::Thread("OSC Multicast Receiver"),
+          multicastAddress(multicastIP), multicastPort(port)
     {
-        // Bind to the port and join multicast group
-        if (multicastSocket.bindToPort(multicastPort))
+        dispatcher.addHandler("/server/catalogue/{snapshot,delta}", [this](const OSCMessageView& message, juce::uint64)
         {
-            if (multicastSocket.joinMulticast(multicastAddress))
+            if (catalogueSync.handleMessage(message))
             {
-                DBG("Successfully joined multicast group on " + multicastIP + ":" + juce::String(port));
+                catalogueChanged = true;
+                catalogueNeedsSaving = true;
             }
-            else
-            {
-                DBG("Failed to join multicast group.");
-            }
-        }
-        else
-        {
-            DBG("Failed to bind to port " + juce::String(port));
-        }
+
+            catalogueServerAddress = currentSenderAddress;
+            catalogueServerPort = currentSenderPort;
+        });
+
+        startThread();
     }
 
-    ~OSCMulticastReceiver()
+    ~OSCMulticastReceiver() override
     {
-        multicastSocket.leaveMulticast(multicastAddress);
+        stopThread(1000);
+
+        if (joined)
+            multicastSocket.leaveMulticast(multicastAddress);
+
+        if (catalogueNeedsSaving)
+            OSCCatalogueCache::write(catalogueCacheFile, catalogueSync.getCatalogue());
     }
 
-    // Method to poll the multicast socket on demand
-    void pollMulticastSocket()
+    // Reads the latest state; lock-free, but each reader thread must use its
+    // own slot and hold only one read at a time
+    StatePublisher::ScopedRead readState(Reader reader) noexcept
     {
-        char buffer[1024];
-        int bytesRead = 0;
-        int lastBytesRead = 0;
+        return StatePublisher::ScopedRead(statePublisher, reader);
+    }
 
-        // Keep reading until the buffer is empty, but only keep the last message
-        do
-        {
-            lastBytesRead = bytesRead;
-            bytesRead = multicastSocket.read(buffer, sizeof(buffer), false);
-        } while (bytesRead > 0);
+    // The source of the datagram being handled; only meaningful inside a
+    // dispatcher handler, on the receive thread
+    const juce::String& getCurrentSenderAddress() const noexcept  { return currentSenderAddress; }
 
-        // Process only the most recent message
-        if (lastBytesRead > 0)
-        {
-            DBG("Received latest data from multicast group: " + juce::String(lastBytesRead) + " bytes.");
+    // True once the socket has joined the multicast group
+    bool isJoined() const noexcept  { return joined; }
 
-            juce::MemoryInputStream stream(buffer, static_cast<size_t>(lastBytesRead), false);
-            parseOSCMessage(stream);
-        }
+    // The address of the last message received (message thread)
+    juce::String getParsedOSCAddress()
+    {
+        const auto state = readState(messageThreadReader);
+        return state->latestPacket.isEmpty() ? juce::String() : state->latestPacket.getLast().addressPattern;
     }
 
-    void parseOSCMessage(juce::MemoryInputStream& stream)
+    // The latest messages for an address, or nullptr if none have arrived.
+    // The entry stays valid for as long as the pointer is held.
+    std::shared_ptr<const CachedOSCMessages> getLatest(const juce::String& address, Reader reader = messageThreadReader)
     {
-        // Clear previous parsed message
-        parsedOSCMessage.clear();
+        const auto state = readState(reader);
+        const auto found = state->messagesByAddress.find(address);
+        return found != state->messagesByAddress.end() ? found->second : nullptr;
+    }
 
-        // Read the OSC address pattern (null-terminated string, aligned to 4 bytes)
-        juce::String addressPattern;
-        addressPattern = readAlignedString(stream);
-        parsedOSCMessage.addressPattern = addressPattern;
-        DBG("Parsed OSC Address: " + parsedOSCMessage.addressPattern);
+    // The latest tags (message thread). A server that keeps a versioned
+    // catalogue is read from that; older servers announce the full list on
+    // tagAddress, and servers that use another address still work: until
+    // something arrives on tagAddress, the latest packet is used instead.
+    juce::StringArray getLatestTags(const juce::String& tagAddress = defaultTagAddress)
+    {
+        DBG("Getting latest tags...");
+        const auto state = readState(messageThreadReader);
 
-        // Read the type tag string (should start with a comma)
-        juce::String typeTagString = readAlignedString(stream);
-        if (!typeTagString.startsWithChar(','))
-        {
-            DBG("Invalid type tag string");
-            return;
-        }
+        if (state->catalogue.isValid())
+            return state->catalogue.getTags();
+
+        const auto* cached = state->find(tagAddress);
+
+        juce::StringArray tags;
 
-        // Iterate over each type tag and read the corresponding argument
-        for (int i = 1; i < typeTagString.length(); ++i) // Start from 1 to skip the comma
+        for (const auto& message : cached != nullptr ? cached->messages : state->latestPacket)
+            for (const auto& argument : message.arguments)
+                tags.add(argument.toString());
+
+        return tags;
+    }
+
+    // The versioned catalogue as last published; copying it only copies
+    // shared pointers
+    OSCTagCatalogue getCatalogue(Reader reader = messageThreadReader)
+    {
+        return readState(reader)->catalogue;
+    }
+
+    static constexpr const char* defaultTagAddress = "/server/tags";
+
+    // Handlers registered here are called on the receive thread for every
+    // message whose address matches, before the new snapshot is published
+    OSCAddressDispatcher& getDispatcher() noexcept  { return dispatcher; }
+
+private:
+    void run() override
+    {
+        // Start from the catalogue the last session saw, so tags are
+        // available before the server has been heard from
+        if (loadCatalogueCache())
+            publishCatalogue();
+
+        while (!threadShouldExit() && !joinGroup())
+            wait(joinRetryIntervalMs);
+
+        while (!threadShouldExit())
         {
-            const auto typeTag = typeTagString[i];
-            switch (typeTag)
+            // Wake up now and then to check whether we should stop
+            const auto ready = multicastSocket.waitUntilReady(true, 100);
+
+            if (ready < 0)
             {
-            case 's':
+                wait(100);
+                continue;
+            }
+
+            requestCatalogueSnapshotIfNeeded();
+            maintainCatalogueCache();
+
+            if (ready == 0)
             {
-                auto str = readAlignedString(stream);
-                parsedOSCMessage.arguments.add(str);
-                DBG("OSC Argument (String): " + str);
-                break;
+                // A newer catalogue may have been picked up from the cache
+                if (catalogueChanged)
+                    publishCatalogue();
+
+                continue;
             }
-            case 'f':
+
+            // Take everything already waiting out of the kernel buffer before
+            // spending time on parsing
+            int numDatagrams = 0;
+
+            while (numDatagrams < numReceiveBuffers)
             {
-                float floatValue = stream.readFloatBigEndian();
-                parsedOSCMessage.arguments.add(juce::String(floatValue));
-                DBG("OSC Argument (Float): " + juce::String(floatValue));
-                break;
+                auto& buffer = receiveBuffers[static_cast<size_t>(numDatagrams)];
+                buffer.size = multicastSocket.read(buffer.data.getData(), maxDatagramSize, false, buffer.senderAddress, buffer.senderPort);
+
+                if (buffer.size <= 0)
+                    break;
+
+                ++numDatagrams;
             }
-            case 'i':
+
+            // Apply the whole burst, oldest first, and publish once
+            auto state = latestState;
+            auto numApplied = 0;
+
+            for (int i = 0; i < numDatagrams; ++i)
             {
-                int intValue = stream.readIntBigEndian();
-                parsedOSCMessage.arguments.add(juce::String(intValue));
-                DBG("OSC Argument (Int): " + juce::String(intValue));
-                break;
+                const auto& buffer = receiveBuffers[static_cast<size_t>(i)];
+                juce::Array<ParsedOSCMessage> packet;
+
+                ++numPacketsReceived;
+                currentSenderAddress = buffer.senderAddress;
+                currentSenderPort = buffer.senderPort;
+
+                if (!parsePacket(buffer.data.getData(), static_cast<size_t>(buffer.size), packet))
+                {
+                    OSCLog::write(OSCLog::Event::multicastMalformed, buffer.size);
+                    continue;
+                }
+
+                OSCLog::write(OSCLog::Event::multicastReceived, buffer.size, packet.size());
+
+                // A packet of nothing but catalogue updates leaves the
+                // address cache alone
+                if (!packet.isEmpty())
+                {
+                    applyPacket(state, std::move(packet));
+                    ++numApplied;
+                }
             }
-            default:
+
+            if (catalogueChanged)
             {
-                DBG("OSC Argument (Unknown Type): " + juce::String(typeTag));
-                break;
+                state.catalogue = catalogueSync.getCatalogue();
+                catalogueChanged = false;
+                ++numApplied;
             }
+
+            requestCatalogueSnapshotIfNeeded();
+
+            if (numApplied > 0)
+            {
+                latestState = state;
+                statePublisher.publish(std::move(state));
             }
         }
+
+        OSCLog::releaseThread();
     }
 
-    // Helper function to read an OSC string and align to 4-byte boundaries
-    juce::String readAlignedString(juce::MemoryInputStream& stream)
+    // Binds and joins the group, keeping whatever succeeded for the next try.
+    // The port may still be held by a previous session, so failures are
+    // retried rather than final.
+    bool joinGroup()
     {
-        juce::String result;
+        if (!bound)
+        {
+            bound = multicastSocket.bindToPort(multicastPort);
+
+            if (!bound)
+            {
+                DBG("Failed to bind to port " + juce::String(multicastPort) + "; retrying");
+                return false;
+            }
+        }
 
-        // Read characters until null terminator is found
-        char c;
-        while ((c = stream.readByte()) != '\0')
+        if (!multicastSocket.joinMulticast(multicastAddress))
         {
-            result += c;
+            DBG("Failed to join multicast group; retrying");
+            return false;
         }
 
-        // Skip padding bytes to maintain 4-byte alignment
-        int padding = (4 - (result.length() + 1) % 4) % 4;
-        stream.skipNextBytes(padding);
+        DBG("Successfully joined multicast group on " + multicastAddress + ":" + juce::String(multicastPort));
+        joined = true;
+        return true;
+    }
 
-        return result;
+    void publishCatalogue()
+    {
+        auto state = latestState;
+        state.catalogue = catalogueSync.getCatalogue();
+        catalogueChanged = false;
+
+        latestState = state;
+        statePublisher.publish(std::move(state));
     }
 
+    // Asks the server that sent the catalogue for a full snapshot, at most
+    // once a second, while a delta has been missed
+    void requestCatalogueSnapshotIfNeeded()
+    {
+        const auto nowMs = juce::Time::getMillisecondCounterHiRes();
 
-    // Getter method for the parsed OSC message
-    const juce::String& getParsedOSCAddress() const
+        if (!catalogueSync.needsSnapshot() || catalogueServerAddress.isEmpty()
+            || nowMs - lastCatalogueRequestMs < catalogueRequestIntervalMs)
+            return;
+
+        char buffer[64];
+        OSCPacketWriter writer(buffer, sizeof(buffer));
+        writer.writeString(OSCTagCatalogueSync::requestAddress);
+        writer.writeString(",i");
+        writer.writeInt32(static_cast<juce::int32>(catalogueSync.getRequestVersion()));
+
+        if (!writer.hasOverflowed())
+            multicastSocket.write(catalogueServerAddress, catalogueServerPort, writer.getData(), static_cast<int>(writer.getSize()));
+
+        lastCatalogueRequestMs = nowMs;
+    }
+
+    // Reads the cache file if it has changed since we last saw it, and takes
+    // its catalogue if it is newer than ours
+    bool loadCatalogueCache()
     {
-        return parsedOSCMessage.addressPattern;
+        const auto modificationTime = catalogueCacheFile.getLastModificationTime();
+
+        if (modificationTime == lastCacheModificationTime)
+            return false;
+
+        lastCacheModificationTime = modificationTime;
+        OSCTagCatalogue cached;
+
+        if (!OSCCatalogueCache::read(catalogueCacheFile, cached))
+            return false;
+
+        const auto& current = catalogueSync.getCatalogue();
+
+        if (current.isValid() && cached.getVersion() <= current.getVersion())
+            return false;
+
+        DBG("Loaded cached tag catalogue " << (int) cached.getVersion() << ": " << cached.size() << " tags");
+        catalogueSync.adopt(cached);
+        catalogueChanged = true;
+        return true;
     }
 
-    juce::StringArray getLatestTags()
+    // Saves catalogue changes now and then, and picks up catalogues saved by
+    // other processes (another host may be receiving when we are not)
+    void maintainCatalogueCache()
     {
-		DBG("Getting latest tags...");
-        pollMulticastSocket();
+        const auto nowMs = juce::Time::getMillisecondCounterHiRes();
 
-        juce::StringArray tags;
-        for (const auto& arg : parsedOSCMessage.arguments)
+        if (nowMs - lastCacheCheckMs < catalogueCacheIntervalMs)
+            return;
+
+        lastCacheCheckMs = nowMs;
+
+        if (catalogueNeedsSaving)
         {
-            tags.add(arg);
+            if (OSCCatalogueCache::write(catalogueCacheFile, catalogueSync.getCatalogue()))
+                lastCacheModificationTime = catalogueCacheFile.getLastModificationTime();
+            else
+                DBG("Failed to save the tag catalogue to " << catalogueCacheFile.getFullPathName());
+
+            catalogueNeedsSaving = false;
+            return;
         }
-        return tags;
+
+        loadCatalogueCache();
     }
 
-private:
-    struct ParsedOSCMessage
+    // Replaces the cache entry of every address in the packet
+    void applyPacket(MulticastState& state, juce::Array<ParsedOSCMessage> packet)
+    {
+        const auto nowMs = juce::Time::getMillisecondCounterHiRes();
+        std::unordered_map<juce::String, std::shared_ptr<CachedOSCMessages>, OSCAddressHash> updated;
+
+        for (const auto& message : packet)
+        {
+            auto& entry = updated[message.addressPattern];
+
+            if (entry == nullptr)
+            {
+                entry = std::make_shared<CachedOSCMessages>();
+
+                if (const auto* previous = state.find(message.addressPattern))
+                    entry->version = previous->version;
+
+                ++entry->version;
+                entry->packetNumber = numPacketsReceived;
+                entry->receivedAtMs = nowMs;
+            }
+
+            entry->messages.add(message);
+        }
+
+        for (auto& [address, entry] : updated)
+            state.messagesByAddress[address] = std::move(entry);
+
+        // Keep the cache small: forget the addresses heard from least recently
+        while (state.messagesByAddress.size() > maxCachedAddresses)
+        {
+            auto oldest = state.messagesByAddress.begin();
+
+            for (auto it = state.messagesByAddress.begin(); it != state.messagesByAddress.end(); ++it)
+                if (it->second->packetNumber < oldest->second->packetNumber)
+                    oldest = it;
+
+            state.messagesByAddress.erase(oldest);
+        }
+
+        state.latestPacket = std::move(packet);
+        state.numPacketsReceived = numPacketsReceived;
+        state.receivedAtMs = nowMs;
+    }
+
+    // Dispatches and copies every message of a packet, or none if any part is malformed
+    bool parsePacket(const char* data, size_t size, juce::Array<ParsedOSCMessage>& messages)
     {
-        juce::String addressPattern;
-        juce::Array<juce::String> arguments;
+        if (!OSCParser::validatePacket(data, size))
+            return false;
 
-        void clear()
+        OSCParser::forEachMessage(data, size, [this, &messages](const OSCMessageView& view, juce::uint64 timeTag)
         {
-            addressPattern.clear();
-            arguments.clear();
+            dispatcher.dispatch(view, timeTag);
+
+            // The catalogue keeps these itself; copying thousands of tags
+            // into the address cache as well would undo the point of deltas
+            if (OSCTagCatalogueSync::isCatalogueAddress(view.getAddress()))
+                return;
+
+            ParsedOSCMessage message;
+            parseOSCMessage(view, message);
+            message.timeTag = timeTag;
+            messages.add(std::move(message));
+        });
+
+        return true;
+    }
+
+    // Copies a validated message out of the receive buffer, keeping each
+    // argument's type
+    static void parseOSCMessage(const OSCMessageView& view, ParsedOSCMessage& parsedOSCMessage)
+    {
+        parsedOSCMessage.addressPattern = juce::String::fromUTF8(view.getAddress().data(), static_cast<int>(view.getAddress().size()));
+        parsedOSCMessage.arguments.ensureStorageAllocated(view.getNumArguments());
+
+        for (const auto& argument : view)
+        {
+            switch (argument.type)
+            {
+                case 'i':  parsedOSCMessage.arguments.add(argument.getInt32()); break;
+                case 'h':  parsedOSCMessage.arguments.add(argument.getInt64()); break;
+                case 't':  parsedOSCMessage.arguments.add(static_cast<juce::int64>(argument.getTimeTag())); break;
+                case 'f':  parsedOSCMessage.arguments.add(argument.getFloat32()); break;
+                case 'd':  parsedOSCMessage.arguments.add(argument.getFloat64()); break;
+                case 'T':
+                case 'F':  parsedOSCMessage.arguments.add(argument.getBool()); break;
+                case 's':
+                case 'S':  parsedOSCMessage.arguments.add(juce::String::fromUTF8(argument.getString().data(), static_cast<int>(argument.size))); break;
+                case 'b':  parsedOSCMessage.arguments.add(juce::var(argument.getBlobData(), argument.getBlobSize())); break;
+                default:   break;
+            }
         }
-    } parsedOSCMessage;
+    }
+
+    // Preallocated and large enough for any UDP datagram, so a burst is read
+    // without growing or copying buffers. Receiving still allocates: JUCE
+    // builds a String for each sender's address, and parsing builds the
+    // published messages. This is the receive thread, not the audio thread.
+    static constexpr int maxDatagramSize = 65536;
+    static constexpr int numReceiveBuffers = 8;
+
+    struct ReceiveBuffer
+    {
+        juce::HeapBlock<char> data { maxDatagramSize };
+        int size = 0;
+        juce::String senderAddress;
+        int senderPort = 0;
+    };
 
     juce::DatagramSocket multicastSocket;
     juce::String multicastAddress;
     int multicastPort;
 
+    static constexpr int joinRetryIntervalMs = 1000;
+
+    bool bound = false;
+    std::atomic<bool> joined { false };
+
+    static constexpr size_t maxCachedAddresses = 64;
+
+    OSCAddressDispatcher dispatcher;
+    std::array<ReceiveBuffer, numReceiveBuffers> receiveBuffers;
+
+    // Receive thread only
+    static constexpr double catalogueRequestIntervalMs = 1000.0;
+
+    OSCTagCatalogueSync catalogueSync;
+    bool catalogueChanged = false;
+    juce::String currentSenderAddress, catalogueServerAddress;
+    int currentSenderPort = 0, catalogueServerPort = 0;
+    double lastCatalogueRequestMs = 0.0;
+
+    static constexpr double catalogueCacheIntervalMs = 5000.0;
+
+    juce::File catalogueCacheFile { OSCCatalogueCache::getDefaultFile() };
+    juce::Time lastCacheModificationTime;
+    bool catalogueNeedsSaving = false;
+    double lastCacheCheckMs = 0.0;
+    juce::uint64 numPacketsReceived = 0;
+
+    // The last state published, kept by the receive thread to build the next one
+    MulticastState latestState;
+    StatePublisher statePublisher { MulticastState() };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OSCMulticastReceiver)
 };
@@ -0,0 +1,388 @@
+/*
+  ==============================================================================
+
+    OSCAddressDispatcher.h
+    Routes incoming OSC messages to handlers registered by address pattern.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <bitset>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "OSCParser.h"
+
+// Handlers register OSC 1.0 address patterns ('?', '*', "[a-z]", "[!0-9]" and
+// "{foo,bar}" within a part); incoming addresses are plain. Patterns are
+// split at '/' and compiled into a trie, so a lookup walks one node per
+// address part: literal parts are a hash lookup, and only the wildcard parts
+// registered at that depth are tried. The cost grows with the address
+// length, not the number of handlers.
+//
+// Registration and dispatch may happen on different threads; they are
+// serialised with a lock, which is fine because neither runs on the audio
+// thread. Handlers run on the dispatching thread.
+class OSCAddressDispatcher
+{
+public:
+    using Handler = std::function<void(const OSCMessageView&, juce::uint64 timeTag)>;
+    using HandlerId = int;
+
+    OSCAddressDispatcher() = default;
+
+    // Returns an id for removeHandler(), or 0 if the pattern is malformed
+    HandlerId addHandler(std::string_view pattern, Handler handler)
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (pattern.empty() || pattern[0] != '/')
+            return 0;
+
+        auto* node = &root;
+
+        for (auto part : splitAddress(pattern))
+        {
+            node = findOrAddChild(*node, part);
+
+            if (node == nullptr)
+                return 0;
+        }
+
+        const auto id = ++lastHandlerId;
+        node->handlers.push_back({ id, std::move(handler) });
+        handlerNodes[id] = node;
+        return id;
+    }
+
+    void removeHandler(HandlerId id)
+    {
+        const juce::ScopedLock sl(lock);
+        const auto found = handlerNodes.find(id);
+
+        if (found == handlerNodes.end())
+            return;
+
+        auto& handlers = found->second->handlers;
+        handlers.erase(std::remove_if(handlers.begin(), handlers.end(),
+                                      [id](const auto& entry) { return entry.first == id; }),
+                       handlers.end());
+        handlerNodes.erase(found);
+    }
+
+    // Calls every handler whose pattern matches the message's address and
+    // returns how many were called
+    int dispatch(const OSCMessageView& message, juce::uint64 timeTag = OSCParser::immediateTimeTag) const
+    {
+        return forEachMatch(message.getAddress(), [&](const Handler& handler) { handler(message, timeTag); });
+    }
+
+    // Calls callback(const Handler&) for every match without dispatching;
+    // returns the number of matches
+    template <typename Callback>
+    int forEachMatch(std::string_view address, Callback&& callback) const
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (address.empty() || address[0] != '/')
+            return 0;
+
+        int numMatches = 0;
+        match(root, address.substr(1), callback, numMatches);
+        return numMatches;
+    }
+
+private:
+    //==============================================================================
+    // One address part of a pattern, compiled into a token sequence
+    struct PartPattern
+    {
+        enum class Type { literal, anyChar, anySequence, charSet, alternatives };
+
+        struct Token
+        {
+            Type type = Type::literal;
+            std::string text;
+            std::bitset<256> chars;
+            std::vector<std::string> choices;
+        };
+
+        std::vector<Token> tokens;
+
+        static bool isPattern(std::string_view part) noexcept
+        {
+            return part.find_first_of("?*[{") != std::string_view::npos;
+        }
+
+        bool compile(std::string_view part)
+        {
+            tokens.clear();
+
+            for (size_t i = 0; i < part.size();)
+            {
+                const auto c = part[i];
+
+                if (c == '?')
+                {
+                    tokens.push_back({ Type::anyChar, {}, {}, {} });
+                    ++i;
+                }
+                else if (c == '*')
+                {
+                    if (tokens.empty() || tokens.back().type != Type::anySequence)
+                        tokens.push_back({ Type::anySequence, {}, {}, {} });
+
+                    ++i;
+                }
+                else if (c == '[')
+                {
+                    const auto close = part.find(']', i + 1);
+
+                    if (close == std::string_view::npos)
+                        return false;
+
+                    Token token { Type::charSet, {}, {}, {} };
+                    auto set = part.substr(i + 1, close - i - 1);
+                    const auto negate = !set.empty() && set[0] == '!';
+
+                    if (negate)
+                        set.remove_prefix(1);
+
+                    for (size_t j = 0; j < set.size(); ++j)
+                    {
+                        // A '-' at either end is literal
+                        if (j + 2 < set.size() && set[j + 1] == '-')
+                        {
+                            for (auto ch = static_cast<unsigned char>(set[j]); ch <= static_cast<unsigned char>(set[j + 2]); ++ch)
+                            {
+                                token.chars.set(ch);
+
+                                if (ch == 255)
+                                    break;
+                            }
+
+                            j += 2;
+                        }
+                        else
+                        {
+                            token.chars.set(static_cast<unsigned char>(set[j]));
+                        }
+                    }
+
+                    if (negate)
+                        token.chars.flip();
+
+                    tokens.push_back(std::move(token));
+                    i = close + 1;
+                }
+                else if (c == '{')
+                {
+                    const auto close = part.find('}', i + 1);
+
+                    if (close == std::string_view::npos)
+                        return false;
+
+                    Token token { Type::alternatives, {}, {}, {} };
+                    auto list = part.substr(i + 1, close - i - 1);
+
+                    for (;;)
+                    {
+                        const auto comma = list.find(',');
+                        token.choices.emplace_back(list.substr(0, comma));
+
+                        if (comma == std::string_view::npos)
+                            break;
+
+                        list.remove_prefix(comma + 1);
+                    }
+
+                    tokens.push_back(std::move(token));
+                    i = close + 1;
+                }
+                else if (c == ']' || c == '}')
+                {
+                    return false;
+                }
+                else
+                {
+                    if (tokens.empty() || tokens.back().type != Type::literal)
+                        tokens.push_back({ Type::literal, {}, {}, {} });
+
+                    tokens.back().text += c;
+                    ++i;
+                }
+            }
+
+            return true;
+        }
+
+        bool matches(std::string_view text) const noexcept
+        {
+            return matchFrom(0, text);
+        }
+
+        bool matchFrom(size_t tokenIndex, std::string_view text) const noexcept
+        {
+            for (; tokenIndex < tokens.size(); ++tokenIndex)
+            {
+                const auto& token = tokens[tokenIndex];
+
+                switch (token.type)
+                {
+                    case Type::literal:
+                        if (text.substr(0, token.text.size()) != token.text)
+                            return false;
+
+                        text.remove_prefix(token.text.size());
+                        break;
+
+                    case Type::anyChar:
+                        if (text.empty())
+                            return false;
+
+                        text.remove_prefix(1);
+                        break;
+
+                    case Type::charSet:
+                        if (text.empty() || !token.chars.test(static_cast<unsigned char>(text[0])))
+                            return false;
+
+                        text.remove_prefix(1);
+                        break;
+
+                    case Type::anySequence:
+                        // A trailing '*' takes the rest; otherwise try every split
+                        if (tokenIndex + 1 == tokens.size())
+                            return true;
+
+                        for (size_t skip = 0; skip <= text.size(); ++skip)
+                            if (matchFrom(tokenIndex + 1, text.substr(skip)))
+                                return true;
+
+                        return false;
+
+                    case Type::alternatives:
+                        for (const auto& choice : token.choices)
+                            if (text.substr(0, choice.size()) == choice
+                                 && matchFrom(tokenIndex + 1, text.substr(choice.size())))
+                                return true;
+
+                        return false;
+                }
+            }
+
+            return text.empty();
+        }
+    };
+
+    struct Node
+    {
+        std::string part;
+        PartPattern pattern;
+
+        // Keys view the children's own part strings, so looking up a
+        // string_view never allocates
+        std::unordered_map<std::string_view, std::unique_ptr<Node>> literalChildren;
+        std::vector<std::unique_ptr<Node>> patternChildren;
+
+        std::vector<std::pair<HandlerId, Handler>> handlers;
+    };
+
+    //==============================================================================
+    static std::vector<std::string_view> splitAddress(std::string_view address)
+    {
+        std::vector<std::string_view> parts;
+        address.remove_prefix(1);
+
+        for (;;)
+        {
+            const auto slash = address.find('/');
+            parts.push_back(address.substr(0, slash));
+
+            if (slash == std::string_view::npos)
+                break;
+
+            address.remove_prefix(slash + 1);
+        }
+
+        return parts;
+    }
+
+    static Node* findOrAddChild(Node& parent, std::string_view part)
+    {
+        if (!PartPattern::isPattern(part))
+        {
+            const auto found = parent.literalChildren.find(part);
+
+            if (found != parent.literalChildren.end())
+                return found->second.get();
+
+            auto child = std::make_unique<Node>();
+            child->part = std::string(part);
+
+            auto* result = child.get();
+            parent.literalChildren.emplace(std::string_view(result->part), std::move(child));
+            return result;
+        }
+
+        for (auto& child : parent.patternChildren)
+            if (child->part == part)
+                return child.get();
+
+        auto child = std::make_unique<Node>();
+        child->part = std::string(part);
+
+        if (!child->pattern.compile(part))
+            return nullptr;
+
+        parent.patternChildren.push_back(std::move(child));
+        return parent.patternChildren.back().get();
+    }
+
+    template <typename Callback>
+    static void match(const Node& node, std::string_view rest, Callback& callback, int& numMatches)
+    {
+        const auto slash = rest.find('/');
+        const auto part = rest.substr(0, slash);
+        const auto isLast = slash == std::string_view::npos;
+        const auto remainder = isLast ? std::string_view() : rest.substr(slash + 1);
+
+        auto visit = [&](const Node& child)
+        {
+            if (!isLast)
+            {
+                match(child, remainder, callback, numMatches);
+                return;
+            }
+
+            for (const auto& entry : child.handlers)
+            {
+                callback(entry.second);
+                ++numMatches;
+            }
+        };
+
+        const auto found = node.literalChildren.find(part);
+
+        if (found != node.literalChildren.end())
+            visit(*found->second);
+
+        for (const auto& child : node.patternChildren)
+            if (child->pattern.matches(part))
+                visit(*child);
+    }
+
+    mutable juce::CriticalSection lock;
+    Node root;
+    std::unordered_map<HandlerId, Node*> handlerNodes;
+    HandlerId lastHandlerId = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OSCAddressDispatcher)
+};
@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    OSCCatalogueCache.h
+    Keeps the last received tag catalogue on disk so that a new session knows
+    it before the server has said anything.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstring>
+#include <vector>
+#include "OSCTagCatalogue.h"
+
+// The file is small and flat so it can be read straight out of a read-only
+// memory mapping:
+//
+//   offset  size
+//        0     8   "OSCTCAT1"
+//        8     4   catalogue version        (little-endian)
+//       12     4   number of tags
+//       16     4   size of the tag data
+//       20     4   FNV-1a hash of the tag data
+//       24     -   tag data: UTF-8, each tag NUL-terminated
+//
+// Writes go to a temporary file that then replaces the cache, so a reader
+// in another process never sees a half-written catalogue; anything that
+// fails the header, size or hash checks is ignored.
+namespace OSCCatalogueCache
+{
+    constexpr char magic[8] = { 'O', 'S', 'C', 'T', 'C', 'A', 'T', '1' };
+    constexpr size_t headerSize = 24;
+
+    inline juce::File getDefaultFile()
+    {
+        return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                   .getChildFile("OSC_Client")
+                   .getChildFile("TagCatalogue.bin");
+    }
+
+    inline void writeUInt32(char* destination, juce::uint32 value) noexcept
+    {
+        const auto littleEndian = juce::ByteOrder::swapIfBigEndian(value);
+        std::memcpy(destination, &littleEndian, sizeof(littleEndian));
+    }
+
+    inline juce::uint32 hash(const char* data, size_t size) noexcept
+    {
+        juce::uint32 result = 2166136261u;
+
+        for (size_t i = 0; i < size; ++i)
+            result = (result ^ static_cast<juce::uint8>(data[i])) * 16777619u;
+
+        return result;
+    }
+
+    // Loads the cache into catalogue; returns false, leaving it untouched, if
+    // there is no usable file
+    inline bool read(const juce::File& file, OSCTagCatalogue& catalogue)
+    {
+        if (!file.existsAsFile())
+            return false;
+
+        const juce::MemoryMappedFile mapped(file, juce::MemoryMappedFile::readOnly);
+        const auto* data = static_cast<const char*>(mapped.getData());
+        const auto size = mapped.getSize();
+
+        if (data == nullptr || size < headerSize || std::memcmp(data, magic, sizeof(magic)) != 0)
+            return false;
+
+        const auto version = juce::ByteOrder::littleEndianInt(data + 8);
+        const auto numTags = juce::ByteOrder::littleEndianInt(data + 12);
+        const auto dataSize = juce::ByteOrder::littleEndianInt(data + 16);
+        const auto* tagData = data + headerSize;
+
+        if (dataSize != size - headerSize || numTags > dataSize
+            || juce::ByteOrder::littleEndianInt(data + 20) != hash(tagData, dataSize))
+            return false;
+
+        std::vector<juce::String> tags;
+        tags.reserve(numTags);
+
+        for (size_t offset = 0; offset < dataSize;)
+        {
+            const auto* tag = tagData + offset;
+            const auto* terminator = static_cast<const char*>(std::memchr(tag, 0, dataSize - offset));
+
+            if (terminator == nullptr)
+                return false;
+
+            tags.push_back(juce::String::fromUTF8(tag, static_cast<int>(terminator - tag)));
+            offset += static_cast<size_t>(terminator - tag) + 1;
+        }
+
+        if (tags.size() != numTags)
+            return false;
+
+        catalogue.reset(version, tags);
+        return true;
+    }
+
+    inline bool write(const juce::File& file, const OSCTagCatalogue& catalogue)
+    {
+        if (!catalogue.isValid() || !file.getParentDirectory().createDirectory())
+            return false;
+
+        juce::MemoryBlock tagData;
+
+        for (const auto& tag : catalogue.getTags())
+            tagData.append(tag.toRawUTF8(), tag.getNumBytesAsUTF8() + 1);
+
+        char header[headerSize];
+        std::memcpy(header, magic, sizeof(magic));
+        writeUInt32(header + 8, catalogue.getVersion());
+        writeUInt32(header + 12, static_cast<juce::uint32>(catalogue.size()));
+        writeUInt32(header + 16, static_cast<juce::uint32>(tagData.getSize()));
+        writeUInt32(header + 20, hash(static_cast<const char*>(tagData.getData()), tagData.getSize()));
+
+        const juce::TemporaryFile temp(file);
+
+        {
+            juce::FileOutputStream out(temp.getFile());
+
+            if (!out.openedOk() || !out.write(header, headerSize) || !out.write(tagData.getData(), tagData.getSize()))
+                return false;
+
+            out.flush();
+        }
+
+        return temp.overwriteTargetFileWithTemporary();
+    }
+}
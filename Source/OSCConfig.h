@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    OSCConfig.h
+    Immutable connection and tag settings shared with the real-time threads.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "OSCControllerCoalescer.h"
+#include "OSCEncoder.h"
+#include "SnapshotPublisher.h"
+
+// How note and controller events are laid out on the wire
+enum class OSCWireFormat
+{
+    strings,    // /midi/message with "note_on"/"note_off"/"controller" and int arguments
+    midi        // /midi/raw with the raw MIDI bytes in a single 'm' argument
+};
+
+// Everything the audio and transport threads need to know about where and how
+// to send. A new instance is built on the message thread whenever a setting
+// changes and published as a whole; readers never see a half-updated config.
+struct OSCClientConfig
+{
+    // Reader slots for SnapshotPublisher
+    enum Reader
+    {
+        audioThreadReader,
+        transportThreadReader,
+        numReaders
+    };
+
+    juce::String ipAddress = "127.0.0.1";
+    int port = 8000;
+
+    // Send to a server found on the multicast group instead: the one called
+    // serverName, or the one with the lowest round trip if that is empty.
+    // ipAddress and port are used while no such server is announcing.
+    bool autoConnect = false;
+    juce::String serverName;
+
+    juce::StringArray tags = { juce::String("piano") };
+    OSCTagSuffix tagSuffix = OSCTagSuffix::fromTags(tags);
+
+    OSCWireFormat wireFormat = OSCWireFormat::strings;
+
+    // Register the tag set with the server and send its handle instead of the
+    // tag strings once acknowledged
+    bool compactTags = false;
+
+    OSCControllerFilter controllerFilter;
+
+    // Render MIDI sent back by the server into processBlock's output
+    bool receiveMidi = false;
+
+    // Measurement mode: append a latency probe to every event (OSCLatency.h).
+    // Only for a stand-in receiver; a real server would read it as tags.
+    bool latencyProbes = false;
+
+    bool bundleEvents = false;
+    int maxDatagramSize = static_cast<int>(OSCEventEncoder::defaultMaxDatagramSize);
+};
+
+using OSCConfigPublisher = SnapshotPublisher<OSCClientConfig, OSCClientConfig::numReaders>;
@@ -0,0 +1,275 @@
+/*
+  ==============================================================================
+
+    OSCControllerCoalescer.h
+    Thins out dense controller streams on the audio thread before queueing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+#include "OSCEncoder.h"
+#include "OSCEventQueue.h"
+
+// Controller thinning applied to every block
+struct OSCControllerFilter
+{
+    // Within a block, only the last value of each channel/controller survives
+    bool coalesce = true;
+
+    // Hold back values that arrive sooner than this after the last one sent
+    // for the same controller; the latest held value goes out once the
+    // interval has passed. 0 disables.
+    double minIntervalMs = 0.0;
+
+    // Drop values that differ from the last one sent by less than this.
+    // 0 and 127 always pass so that end stops are never lost. 0 disables.
+    int minDelta = 0;
+};
+
+// Rewrites a block of events so that automation lanes emitting hundreds of
+// CCs per block produce a handful of messages. Notes act as barriers: a CC
+// that came before a note on the same channel is always sent before it, with
+// the value it had at that point, so nothing is reordered relative to notes.
+//
+// process() runs on the audio thread and never allocates or locks; reset()
+// must not run concurrently with it.
+class OSCControllerCoalescer
+{
+public:
+    OSCControllerCoalescer()
+        : slots(numChannels * numControllers)
+    {
+        deferredSlots.reserve(slots.size());
+        reset();
+    }
+
+    void reset()
+    {
+        for (auto& slot : slots)
+            slot = {};
+
+        channelSegments.fill(0);
+        deferredSlots.clear();
+    }
+
+    // Filters numInput events into output (at most maxOutput) and returns the
+    // number written. Held-back values whose interval has passed are emitted
+    // at the start of the block. Input events that did not fit are dropped
+    // and their number stored in numTruncated.
+    int process(const OSCEvent* input, int numInput, OSCEvent* output, int maxOutput,
+                const OSCControllerFilter& filter, double blockStartSeconds, double sampleRate,
+                juce::uint32 blockIndex, int& numTruncated) noexcept
+    {
+        const auto minIntervalSeconds = filter.minIntervalMs / 1000.0;
+        juce::uint64 numSuppressed = 0;
+        int numOutput = 0;
+
+        // Coalescing never crosses a block boundary
+        for (auto& segment : channelSegments)
+            ++segment;
+
+        // Release held-back values that are now due
+        const auto blockStartTimeTag = OSCEventEncoder::toTimeTag(blockStartSeconds);
+
+        releaseDeferred(output, numOutput, maxOutput, -1, [&](const ControllerSlot& slot)
+        {
+            return blockStartSeconds - slot.lastSentSeconds >= minIntervalSeconds;
+        }, 0, blockIndex, blockStartTimeTag, blockStartSeconds);
+
+        int numRead = 0;
+
+        for (; numRead < numInput && numOutput < maxOutput; ++numRead)
+        {
+            const auto& event = input[numRead];
+            const auto channel = getChannelIndex(event);
+
+            if (!event.isController())
+            {
+                // Anything held back on this channel must go out before the
+                // note. If that and the note do not both fit, the note is left
+                // unread so that it is counted as truncated rather than lost.
+                if (numOutput + countDeferred(channel) >= maxOutput)
+                    break;
+
+                releaseDeferred(output, numOutput, maxOutput, channel, [](const ControllerSlot&) { return true; },
+                                event.samplePosition, event.blockIndex, event.timeTag,
+                                blockStartSeconds + event.samplePosition / sampleRate);
+
+                ++channelSegments[(size_t) channel];
+                output[numOutput++] = event;
+                continue;
+            }
+
+            const auto slotIndex = getSlotIndex(event);
+            auto& slot = slots[(size_t) slotIndex];
+            const auto value = static_cast<int>(event.data2);
+            const auto eventSeconds = blockStartSeconds + event.samplePosition / sampleRate;
+
+            // Last value wins: replace the earlier value from this segment
+            if (filter.coalesce && slot.pendingIndex >= 0 && slot.pendingSegment == channelSegments[(size_t) channel])
+            {
+                output[slot.pendingIndex].status = 0;
+                ++numSuppressed;
+                append(output, numOutput, slot, event, eventSeconds);
+                continue;
+            }
+
+            if (filter.minDelta > 0 && slot.lastSentValue >= 0 && value != 0 && value != 127
+                 && std::abs(value - slot.lastSentValue) < filter.minDelta)
+            {
+                ++numSuppressed;
+                continue;
+            }
+
+            if (minIntervalSeconds > 0.0 && slot.lastSentValue >= 0
+                 && eventSeconds - slot.lastSentSeconds < minIntervalSeconds)
+            {
+                if (slot.deferred)
+                    ++numSuppressed;
+                else
+                    deferredSlots.push_back(slotIndex);
+
+                slot.deferred = true;
+                slot.deferredEvent = event;
+                continue;
+            }
+
+            // A newer value supersedes anything held back for this controller
+            if (slot.deferred)
+            {
+                slot.deferred = false;
+                ++numSuppressed;
+            }
+
+            append(output, numOutput, slot, event, eventSeconds);
+        }
+
+        numTruncated = numInput - numRead;
+
+        // Remove the values that were replaced
+        int numKept = 0;
+        juce::uint64 numControllersSent = 0;
+
+        for (int i = 0; i < numOutput; ++i)
+        {
+            if (output[i].status == 0)
+                continue;
+
+            if (output[i].isController())
+            {
+                slots[(size_t) getSlotIndex(output[i])].pendingIndex = -1;
+                ++numControllersSent;
+            }
+
+            output[numKept++] = output[i];
+        }
+
+        sentCount.fetch_add(numControllersSent, std::memory_order_relaxed);
+        suppressedCount.fetch_add(numSuppressed, std::memory_order_relaxed);
+        return numKept;
+    }
+
+    // Controller messages passed on / dropped or merged since construction
+    juce::uint64 getNumSent() const noexcept        { return sentCount.load(std::memory_order_relaxed); }
+    juce::uint64 getNumSuppressed() const noexcept  { return suppressedCount.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int numChannels = 16;
+    static constexpr int numControllers = 128;
+
+    struct ControllerSlot
+    {
+        int lastSentValue = -1;
+        double lastSentSeconds = 0.0;
+
+        // Position in this block's output, valid while pendingSegment matches
+        int pendingIndex = -1;
+        juce::uint32 pendingSegment = 0;
+
+        bool deferred = false;
+        OSCEvent deferredEvent;
+    };
+
+    // 0-15, unlike OSCEvent::getChannel()
+    static int getChannelIndex(const OSCEvent& event) noexcept
+    {
+        return event.status & 0x0f;
+    }
+
+    static int getSlotIndex(const OSCEvent& event) noexcept
+    {
+        return getChannelIndex(event) * numControllers + (event.data1 & 0x7f);
+    }
+
+    void append(OSCEvent* output, int& numOutput, ControllerSlot& slot, const OSCEvent& event, double eventSeconds) noexcept
+    {
+        slot.lastSentValue = static_cast<int>(event.data2);
+        slot.lastSentSeconds = eventSeconds;
+        slot.pendingIndex = numOutput;
+        slot.pendingSegment = channelSegments[(size_t) getChannelIndex(event)];
+        output[numOutput++] = event;
+    }
+
+    // Values currently held back on one channel
+    int countDeferred(int channel) const noexcept
+    {
+        int numDeferred = 0;
+
+        for (auto slotIndex : deferredSlots)
+            if (slots[(size_t) slotIndex].deferred && slotIndex / numControllers == channel)
+                ++numDeferred;
+
+        return numDeferred;
+    }
+
+    // Emits held-back values (for one channel, or all if channel is -1) that
+    // isDue accepts, stamped with the given position and time
+    template <typename Predicate>
+    void releaseDeferred(OSCEvent* output, int& numOutput, int maxOutput, int channel, Predicate&& isDue,
+                         int samplePosition, juce::uint32 blockIndex, juce::uint64 timeTag, double seconds) noexcept
+    {
+        size_t numRemaining = 0;
+
+        for (auto slotIndex : deferredSlots)
+        {
+            auto& slot = slots[(size_t) slotIndex];
+
+            if (!slot.deferred)
+                continue;
+
+            if ((channel < 0 || slotIndex / numControllers == channel) && isDue(slot) && numOutput < maxOutput)
+            {
+                auto event = slot.deferredEvent;
+                event.samplePosition = samplePosition;
+                event.blockIndex = blockIndex;
+                event.timeTag = timeTag;
+
+                slot.deferred = false;
+                append(output, numOutput, slot, event, seconds);
+                continue;
+            }
+
+            deferredSlots[numRemaining++] = slotIndex;
+        }
+
+        deferredSlots.resize(numRemaining);
+    }
+
+    std::vector<ControllerSlot> slots;
+    std::array<juce::uint32, numChannels> channelSegments {};
+
+    // Slots holding a deferred value; reserved up front so push_back never allocates
+    std::vector<int> deferredSlots;
+
+    std::atomic<juce::uint64> sentCount { 0 };
+    std::atomic<juce::uint64> suppressedCount { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OSCControllerCoalescer)
+};
@@ -0,0 +1,475 @@
+/*
+  ==============================================================================
+
+    OSCEncoder.h
+    Allocation-free OSC 1.0 packet encoding into caller-owned buffers.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstring>
+#include "OSCEventQueue.h"
+#include "OSCLatency.h"
+
+// Writes OSC primitives straight into a fixed-size buffer owned by the caller.
+// Nothing here touches the heap: if a write would run past the end of the
+// buffer it is refused and the writer remembers that it overflowed, so the
+// caller can check once at the end instead of after every call.
+class OSCPacketWriter
+{
+public:
+    OSCPacketWriter(char* destination, size_t capacityInBytes) noexcept
+        : data(destination), capacity(capacityInBytes)
+    {
+    }
+
+    void reset() noexcept
+    {
+        size = 0;
+        overflowed = false;
+    }
+
+    const char* getData() const noexcept    { return data; }
+    size_t getSize() const noexcept         { return size; }
+    size_t getCapacity() const noexcept     { return capacity; }
+    bool hasOverflowed() const noexcept     { return overflowed; }
+
+    bool writeBytes(const void* source, size_t numBytes) noexcept
+    {
+        if (numBytes == 0)
+            return !overflowed;
+
+        if (!ensureSpace(numBytes))
+            return false;
+
+        std::memcpy(data + size, source, numBytes);
+        size += numBytes;
+        return true;
+    }
+
+    // OSC-string: the characters, a null terminator, then zeros up to a multiple of 4
+    bool writeString(const char* text, size_t length) noexcept
+    {
+        const auto paddedLength = getPaddedStringSize(length);
+
+        if (!ensureSpace(paddedLength))
+            return false;
+
+        std::memcpy(data + size, text, length);
+        std::memset(data + size + length, 0, paddedLength - length);
+        size += paddedLength;
+        return true;
+    }
+
+    bool writeString(const char* text) noexcept
+    {
+        return writeString(text, std::strlen(text));
+    }
+
+    bool writeString(const juce::String& text) noexcept
+    {
+        return writeString(text.toRawUTF8(), text.getNumBytesAsUTF8());
+    }
+
+    // Type-tag string made of a fixed prefix (including the leading comma)
+    // followed by precomputed trailing tags, e.g. ",siit" + "sss", and
+    // optionally a few more after those
+    bool writeTypeTags(const char* prefix, const char* suffix, size_t suffixLength, const char* extra = "") noexcept
+    {
+        const auto prefixLength = std::strlen(prefix);
+        const auto extraLength = std::strlen(extra);
+        const auto length = prefixLength + suffixLength + extraLength;
+        const auto paddedLength = getPaddedStringSize(length);
+
+        if (!ensureSpace(paddedLength))
+            return false;
+
+        std::memcpy(data + size, prefix, prefixLength);
+
+        if (suffixLength > 0)
+            std::memcpy(data + size + prefixLength, suffix, suffixLength);
+
+        if (extraLength > 0)
+            std::memcpy(data + size + prefixLength + suffixLength, extra, extraLength);
+
+        std::memset(data + size + length, 0, paddedLength - length);
+        size += paddedLength;
+        return true;
+    }
+
+    bool writeInt32(juce::int32 value) noexcept
+    {
+        return writeBigEndian32(static_cast<juce::uint32>(value));
+    }
+
+    // OSC 'h' argument
+    bool writeInt64(juce::int64 value) noexcept
+    {
+        return writeBigEndian32(static_cast<juce::uint32>(static_cast<juce::uint64>(value) >> 32))
+            && writeBigEndian32(static_cast<juce::uint32>(value));
+    }
+
+    // OSC 'm' argument: port id, status byte, data1, data2
+    bool writeMidi(juce::uint8 portId, juce::uint8 status, juce::uint8 data1, juce::uint8 data2) noexcept
+    {
+        const juce::uint8 bytes[] = { portId, status, data1, data2 };
+        return writeBytes(bytes, sizeof(bytes));
+    }
+
+    bool writeFloat32(float value) noexcept
+    {
+        juce::uint32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return writeBigEndian32(bits);
+    }
+
+    // 64-bit NTP-format time tag: seconds since 1900 in the high word, fraction in the low word
+    bool writeTimeTag(juce::uint64 timeTag) noexcept
+    {
+        return writeBigEndian32(static_cast<juce::uint32>(timeTag >> 32))
+            && writeBigEndian32(static_cast<juce::uint32>(timeTag));
+    }
+
+    static size_t getPaddedStringSize(size_t length) noexcept
+    {
+        return (length + 4) & ~static_cast<size_t>(3);
+    }
+
+private:
+    bool ensureSpace(size_t numBytes) noexcept
+    {
+        if (overflowed || numBytes > capacity - size)
+        {
+            overflowed = true;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool writeBigEndian32(juce::uint32 value) noexcept
+    {
+        if (!ensureSpace(4))
+            return false;
+
+        auto* dest = reinterpret_cast<juce::uint8*>(data + size);
+        dest[0] = static_cast<juce::uint8>(value >> 24);
+        dest[1] = static_cast<juce::uint8>(value >> 16);
+        dest[2] = static_cast<juce::uint8>(value >> 8);
+        dest[3] = static_cast<juce::uint8>(value);
+        size += 4;
+        return true;
+    }
+
+    char* data;
+    size_t capacity;
+    size_t size = 0;
+    bool overflowed = false;
+};
+
+// Arguments that follow every event message, serialised once when they change
+// rather than per event: the extra type-tag characters and the already padded
+// argument bytes. Encoding an event then only needs two memcpy calls.
+struct OSCTagSuffix
+{
+    juce::MemoryBlock typeTags;
+    juce::MemoryBlock payload;
+    int numTags = 0;
+    bool usesHandle = false;
+
+    // One OSC-string argument per tag
+    static OSCTagSuffix fromTags(const juce::StringArray& tags)
+    {
+        OSCTagSuffix suffix;
+        suffix.numTags = tags.size();
+
+        size_t payloadSize = 0;
+        for (const auto& tag : tags)
+            payloadSize += OSCPacketWriter::getPaddedStringSize(tag.getNumBytesAsUTF8());
+
+        suffix.typeTags.setSize(static_cast<size_t>(tags.size()));
+        suffix.typeTags.fill('s');
+
+        suffix.payload.setSize(payloadSize);
+        OSCPacketWriter writer(static_cast<char*>(suffix.payload.getData()), payloadSize);
+
+        for (const auto& tag : tags)
+            writer.writeString(tag);
+
+        return suffix;
+    }
+
+    // A single int32 handle the server assigned to a registered tag set
+    static OSCTagSuffix fromHandle(juce::int32 handle)
+    {
+        OSCTagSuffix suffix;
+        suffix.usesHandle = true;
+
+        suffix.typeTags.setSize(1);
+        suffix.typeTags.fill('i');
+
+        suffix.payload.setSize(sizeof(juce::int32));
+        OSCPacketWriter writer(static_cast<char*>(suffix.payload.getData()), suffix.payload.getSize());
+        writer.writeInt32(handle);
+
+        return suffix;
+    }
+
+    const char* getTypeTags() const noexcept    { return static_cast<const char*>(typeTags.getData()); }
+    size_t getNumTypeTags() const noexcept      { return typeTags.getSize(); }
+};
+
+namespace OSCEventEncoder
+{
+    // Largest payload that fits in a single UDP datagram
+    constexpr size_t maxPacketSize = 65507;
+
+    // Largest datagram that avoids IP fragmentation on a 1500-byte Ethernet MTU
+    constexpr size_t defaultMaxDatagramSize = 1472;
+
+    // Special time tag meaning "process immediately"
+    constexpr juce::uint64 immediateTimeTag = 1;
+
+    // Seconds between the NTP epoch (1900) and the Unix epoch (1970)
+    constexpr double ntpEpochOffsetSeconds = 2208988800.0;
+
+    // Converts a Unix time in seconds into a 32.32 fixed-point NTP time tag
+    inline juce::uint64 toTimeTag(double secondsSinceUnixEpoch) noexcept
+    {
+        const auto ntpSeconds = secondsSinceUnixEpoch + ntpEpochOffsetSeconds;
+        const auto wholeSeconds = static_cast<juce::uint64>(ntpSeconds);
+        const auto fraction = static_cast<juce::uint64>((ntpSeconds - static_cast<double>(wholeSeconds)) * 4294967296.0);
+
+        return (wholeSeconds << 32) | (fraction & 0xffffffffu);
+    }
+
+    inline double toSecondsSinceUnixEpoch(juce::uint64 timeTag) noexcept
+    {
+        return static_cast<double>(timeTag >> 32) - ntpEpochOffsetSeconds
+             + static_cast<double>(timeTag & 0xffffffffu) / 4294967296.0;
+    }
+
+    // Appends a latency probe's arguments, if there is one
+    inline void writeProbe(OSCPacketWriter& writer, const OSCLatencyProbe* probe) noexcept
+    {
+        if (probe == nullptr)
+            return;
+
+        writer.writeInt32(static_cast<juce::int32>(probe->entryMicros));
+        writer.writeInt32(probe->instanceId);
+    }
+
+    // Encodes an event as:
+    //   /midi/message ,siit "note_on" note velocity timetag tag...
+    //   /midi/message ,sit  "note_off" note timetag tag...
+    //   /midi/message ,siit "controller" number value timetag tag...
+    // The timetag is the absolute time at which the event should sound.
+    // With a handle suffix the address is /midi/message_id and the tags are
+    // replaced by a single int32 handle. With a probe, its two int32s follow
+    // the tags (see OSCLatency.h).
+    // Returns false if the event is not a note or controller, or if the
+    // packet does not fit into the writer.
+    inline bool writeEvent(OSCPacketWriter& writer, const OSCEvent& event, const OSCTagSuffix& suffix,
+                           const OSCLatencyProbe* probe = nullptr) noexcept
+    {
+        const auto* typeTags = suffix.getTypeTags();
+        const auto numTypeTags = suffix.getNumTypeTags();
+        const auto* probeTags = probe != nullptr ? OSCLatencyProbe::typeTags : "";
+
+        if (suffix.usesHandle)
+            writer.writeString("/midi/message_id", 16);
+        else
+            writer.writeString("/midi/message", 13);
+
+        if (event.isNoteOn())
+        {
+            writer.writeTypeTags(",siit", typeTags, numTypeTags, probeTags);
+            writer.writeString("note_on", 7);
+            writer.writeInt32(event.data1);
+            writer.writeInt32(event.data2);
+        }
+        else if (event.isNoteOff())
+        {
+            writer.writeTypeTags(",sit", typeTags, numTypeTags, probeTags);
+            writer.writeString("note_off", 8);
+            writer.writeInt32(event.data1);
+        }
+        else if (event.isController())
+        {
+            writer.writeTypeTags(",siit", typeTags, numTypeTags, probeTags);
+            writer.writeString("controller", 10);
+            writer.writeInt32(event.data1);
+            writer.writeInt32(event.data2);
+        }
+        else
+        {
+            return false;
+        }
+
+        writer.writeTimeTag(event.timeTag);
+        writer.writeBytes(suffix.payload.getData(), suffix.payload.getSize());
+        writeProbe(writer, probe);
+
+        return !writer.hasOverflowed();
+    }
+
+    // Encodes an event as its raw MIDI bytes:
+    //   /midi/raw ,mt midi timetag tag...
+    // or, with a handle suffix, /midi/raw_id ,mti midi timetag handle,
+    // followed by the probe's two int32s if there is one.
+    // Every event has the same shape, so servers can switch on the status
+    // byte instead of comparing strings. Returns false if the packet does
+    // not fit into the writer.
+    inline bool writeMidiEvent(OSCPacketWriter& writer, const OSCEvent& event, const OSCTagSuffix& suffix,
+                               const OSCLatencyProbe* probe = nullptr) noexcept
+    {
+        if (suffix.usesHandle)
+            writer.writeString("/midi/raw_id", 12);
+        else
+            writer.writeString("/midi/raw", 9);
+
+        writer.writeTypeTags(",mt", suffix.getTypeTags(), suffix.getNumTypeTags(),
+                             probe != nullptr ? OSCLatencyProbe::typeTags : "");
+        writer.writeMidi(0, event.status, event.data1, event.data2);
+        writer.writeTimeTag(event.timeTag);
+        writer.writeBytes(suffix.payload.getData(), suffix.payload.getSize());
+        writeProbe(writer, probe);
+
+        return !writer.hasOverflowed();
+    }
+
+    // One named figure in a stats reply
+    struct StatValue
+    {
+        const char* name;
+        juce::uint64 value;
+    };
+
+    // Answers a /client/stats request:
+    //   /client/stats_reply ,ii[sh...][s...] nonce instanceId name value... tag...
+    // The figures are name/value pairs so servers can pick out the ones they
+    // know; the instance's tags follow, as on its MIDI messages.
+    inline bool writeStatsReply(OSCPacketWriter& writer, juce::int32 nonce, juce::int32 instanceId,
+                                const StatValue* values, int numValues, const OSCTagSuffix& tagSuffix) noexcept
+    {
+        constexpr int maxValues = 60;
+        jassert(numValues <= maxValues);
+        numValues = juce::jmin(numValues, maxValues);
+
+        char typeTags[4 + 2 * maxValues] = ",ii";
+
+        for (int i = 0; i < numValues; ++i)
+        {
+            typeTags[3 + 2 * i] = 's';
+            typeTags[4 + 2 * i] = 'h';
+        }
+
+        typeTags[3 + 2 * numValues] = 0;
+
+        writer.writeString("/client/stats_reply", 19);
+        writer.writeTypeTags(typeTags, tagSuffix.getTypeTags(), tagSuffix.getNumTypeTags());
+        writer.writeInt32(nonce);
+        writer.writeInt32(instanceId);
+
+        for (int i = 0; i < numValues; ++i)
+        {
+            writer.writeString(values[i].name);
+            writer.writeInt64(static_cast<juce::int64>(values[i].value));
+        }
+
+        writer.writeBytes(tagSuffix.payload.getData(), tagSuffix.payload.getSize());
+        return !writer.hasOverflowed();
+    }
+
+    // Asks the server for a compact handle for a tag set:
+    //   /client/register_tags ,i[s...] nonce tag...
+    // The server answers /client/tags_ack ,ii nonce handle to the sender's address.
+    inline bool writeTagRegistration(OSCPacketWriter& writer, juce::int32 nonce, const OSCTagSuffix& tagSuffix) noexcept
+    {
+        writer.writeString("/client/register_tags", 21);
+        writer.writeTypeTags(",i", tagSuffix.getTypeTags(), tagSuffix.getNumTypeTags());
+        writer.writeInt32(nonce);
+        writer.writeBytes(tagSuffix.payload.getData(), tagSuffix.payload.getSize());
+
+        return !writer.hasOverflowed();
+    }
+}
+
+// Packs already-encoded OSC messages into "#bundle" packets, preserving their
+// order and starting a new bundle whenever the next element would push the
+// packet past the configured datagram size. Like OSCPacketWriter it works
+// entirely inside a buffer supplied by the caller.
+//
+// A bundle can hold events from many blocks and instances, so its own time
+// tag is always "immediate": a server that dispatches on the bundle's tag
+// would otherwise play everything at the first event's time. Each message
+// keeps its sample-accurate time in its own 't' argument.
+class OSCBundleBuilder
+{
+public:
+    OSCBundleBuilder(char* destination, size_t capacityInBytes) noexcept
+        : writer(destination, capacityInBytes), maxDatagramSize(capacityInBytes)
+    {
+    }
+
+    void setMaxDatagramSize(size_t newSize) noexcept
+    {
+        maxDatagramSize = juce::jlimit(minDatagramSize, writer.getCapacity(), newSize);
+    }
+
+    size_t getMaxDatagramSize() const noexcept  { return maxDatagramSize; }
+    bool isEmpty() const noexcept               { return numElements == 0; }
+
+    // Appends one encoded message. If it does not fit in the current bundle the
+    // bundle is handed to sendPacket first; a message too large for any bundle
+    // is sent on its own. sendPacket is called as sendPacket(const char*, size_t).
+    template <typename SendFunction>
+    void addMessage(const char* message, size_t messageSize, SendFunction&& sendPacket)
+    {
+        const auto elementSize = sizeof(juce::int32) + messageSize;
+
+        if (headerSize + elementSize > maxDatagramSize)
+        {
+            flush(sendPacket);
+            sendPacket(message, messageSize);
+            return;
+        }
+
+        if (numElements > 0 && writer.getSize() + elementSize > maxDatagramSize)
+            flush(sendPacket);
+
+        if (numElements == 0)
+        {
+            writer.reset();
+            writer.writeString("#bundle", 7);
+            writer.writeTimeTag(OSCEventEncoder::immediateTimeTag);
+        }
+
+        writer.writeInt32(static_cast<juce::int32>(messageSize));
+        writer.writeBytes(message, messageSize);
+        ++numElements;
+    }
+
+    template <typename SendFunction>
+    void flush(SendFunction&& sendPacket)
+    {
+        if (numElements == 0)
+            return;
+
+        sendPacket(writer.getData(), writer.getSize());
+        numElements = 0;
+        writer.reset();
+    }
+
+private:
+    // "#bundle\0" followed by the 8-byte time tag
+    static constexpr size_t headerSize = 16;
+    static constexpr size_t minDatagramSize = 64;
+
+    OSCPacketWriter writer;
+    size_t maxDatagramSize;
+    int numElements = 0;
+};
@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    OSCEventQueue.h
+    Lock-free hand-off of MIDI events from the audio thread to the sender thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <atomic>
+
+// Compact record of a single MIDI event captured in processBlock.
+// Kept trivially copyable so the audio thread only ever copies a few bytes.
+struct OSCEvent
+{
+    juce::uint8 status = 0;     // Raw MIDI status byte (message type | channel)
+    juce::uint8 data1 = 0;      // Note or controller number
+    juce::uint8 data2 = 0;      // Velocity or controller value
+    juce::uint8 reserved = 0;
+    int samplePosition = 0;     // Offset of the event inside its processBlock call
+    juce::uint32 blockIndex = 0; // Which processBlock call the event came from
+    juce::uint32 entryMicros = 0; // Probe clock when the block entered processBlock (see OSCLatency.h)
+    juce::uint64 timeTag = 0;   // Absolute NTP-format time at which the event should sound
+
+    bool isNoteOn() const       { return (status & 0xf0) == 0x90 && data2 != 0; }
+    bool isNoteOff() const      { return (status & 0xf0) == 0x80 || ((status & 0xf0) == 0x90 && data2 == 0); }
+    bool isController() const   { return (status & 0xf0) == 0xb0; }
+    int getChannel() const      { return (status & 0x0f) + 1; }
+};
+
+// Single-producer/single-consumer ring of OSCEvents. All storage is allocated
+// up front, so push() is wait-free and never touches the heap. When the ring is
+// full the event is dropped and counted rather than blocking the audio thread.
+class OSCEventQueue
+{
+public:
+    explicit OSCEventQueue(int capacity)
+        : fifo(capacity), events(static_cast<size_t>(capacity), true)
+    {
+    }
+
+    // Called from the audio thread only
+    bool push(const OSCEvent& event)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+        {
+            overflowCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        events[size1 > 0 ? start1 : start2] = event;
+        fifo.finishedWrite(1);
+
+        const auto numQueued = fifo.getNumReady();
+        if (numQueued > highWaterMark.load(std::memory_order_relaxed))
+            highWaterMark.store(numQueued, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    // Called from the audio thread only. Publishes a whole block's events with a
+    // single commit, so the consumer never observes half a block. If the ring
+    // cannot hold all of them the block is dropped and every event is counted.
+    bool push(const OSCEvent* blockEvents, int numEvents)
+    {
+        if (numEvents <= 0)
+            return true;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(numEvents, start1, size1, start2, size2);
+
+        if (size1 + size2 < numEvents)
+        {
+            overflowCount.fetch_add(static_cast<juce::uint64>(numEvents), std::memory_order_relaxed);
+            return false;
+        }
+
+        std::copy(blockEvents, blockEvents + size1, events.getData() + start1);
+        std::copy(blockEvents + size1, blockEvents + numEvents, events.getData() + start2);
+        fifo.finishedWrite(numEvents);
+
+        const auto numQueued = fifo.getNumReady();
+        if (numQueued > highWaterMark.load(std::memory_order_relaxed))
+            highWaterMark.store(numQueued, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    // Called from the consumer thread only; hands every queued event to the
+    // callback in arrival order and returns how many were consumed.
+    template <typename Callback>
+    int popAll(Callback&& callback)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; ++i)
+            callback(events[start1 + i]);
+
+        for (int i = 0; i < size2; ++i)
+            callback(events[start2 + i]);
+
+        fifo.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+
+    int getCapacity() const             { return fifo.getTotalSize() - 1; }
+    int getNumQueued() const            { return fifo.getNumReady(); }
+    int getHighWaterMark() const        { return highWaterMark.load(std::memory_order_relaxed); }
+    juce::uint64 getOverflowCount() const { return overflowCount.load(std::memory_order_relaxed); }
+
+private:
+    juce::AbstractFifo fifo;
+    juce::HeapBlock<OSCEvent> events;
+
+    std::atomic<int> highWaterMark { 0 };
+    std::atomic<juce::uint64> overflowCount { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OSCEventQueue)
+};
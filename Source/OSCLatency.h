@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    OSCLatency.h
+    Latency probes carried on outgoing events, and the histogram their
+    round trips are collected in.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string_view>
+#include "OSCParser.h"
+
+// In measurement mode every note and controller message carries two extra
+// int32 arguments after its tags or handle:
+//
+//   ... entryMicros instanceId
+//
+// entryMicros is the low 32 bits of the monotonic clock, in microseconds,
+// when the event's block entered processBlock; instanceId tells the plugin
+// instances in a session apart. A receiver on the same machine reads the
+// same clock on arrival, so the difference is the time from processBlock to
+// the socket, through the queue, the transport thread and the network stack.
+// It wraps after 71 minutes, far beyond any latency worth measuring.
+//
+// The extra arguments look like more tags to a real server, so probes are
+// for a stand-in receiver (Tools/OSCLatencyReceiver.cpp or the processBlock
+// benchmark's sink) only.
+struct OSCLatencyProbe
+{
+    juce::uint32 entryMicros = 0;
+    juce::int32 instanceId = 0;
+
+    static constexpr const char* typeTags = "ii";
+
+    // The probe clock; the same on every thread and process on a machine
+    static juce::uint32 nowMicros() noexcept
+    {
+        const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks());
+        return static_cast<juce::uint32>(static_cast<juce::uint64>(seconds * 1.0e6));
+    }
+
+    // Microseconds from entry to now, allowing for the clock having wrapped
+    juce::uint32 getAgeMicros(juce::uint32 now) const noexcept
+    {
+        return now - entryMicros;
+    }
+
+    // Reads the probe off the end of a /midi/... message. Returns false if
+    // the message does not end in two int32 arguments.
+    static bool read(const OSCMessageView& message, OSCLatencyProbe& probe) noexcept
+    {
+        const auto tags = message.getTypeTags();
+
+        if (message.getAddress().substr(0, 6) != "/midi/" || tags.size() < 3
+            || tags.substr(tags.size() - 2) != typeTags)
+            return false;
+
+        auto argument = message.begin();
+
+        for (size_t i = 0; i < tags.size() - 2; ++i)
+            ++argument;
+
+        probe.entryMicros = static_cast<juce::uint32>(argument->getInt32());
+        probe.instanceId = (++argument)->getInt32();
+        return true;
+    }
+};
+
+// Log-linear histogram of latencies in microseconds, after HdrHistogram:
+// exact below 64 us, then 32 buckets per doubling, so any percentile is
+// within about 3% of the true value, across the whole 32-bit range in a
+// fixed 7 KB with no allocation. Not thread-safe; one writer at a time.
+class OSCLatencyHistogram
+{
+public:
+    void record(juce::uint32 micros) noexcept
+    {
+        ++counts[static_cast<size_t>(getBucket(micros))];
+        ++count;
+        total += micros;
+        minimum = std::min(minimum, micros);
+        maximum = std::max(maximum, micros);
+    }
+
+    void merge(const OSCLatencyHistogram& other) noexcept
+    {
+        for (size_t i = 0; i < counts.size(); ++i)
+            counts[i] += other.counts[i];
+
+        count += other.count;
+        total += other.total;
+        minimum = std::min(minimum, other.minimum);
+        maximum = std::max(maximum, other.maximum);
+    }
+
+    void reset() noexcept
+    {
+        *this = {};
+    }
+
+    juce::uint64 getCount() const noexcept  { return count; }
+    juce::uint32 getMin() const noexcept    { return count > 0 ? minimum : 0; }
+    juce::uint32 getMax() const noexcept    { return maximum; }
+    double getMean() const noexcept         { return count > 0 ? static_cast<double>(total) / static_cast<double>(count) : 0.0; }
+
+    // The highest value in the bucket holding the given percentile (0-100),
+    // capped at the largest value recorded
+    juce::uint32 getPercentile(double percentile) const noexcept
+    {
+        if (count == 0)
+            return 0;
+
+        const auto rank = std::max<juce::uint64>(1, static_cast<juce::uint64>(std::ceil(percentile / 100.0 * static_cast<double>(count))));
+        juce::uint64 seen = 0;
+
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            seen += counts[i];
+
+            if (seen >= rank)
+                return std::min(maximum, getBucketHighest(static_cast<int>(i)));
+        }
+
+        return maximum;
+    }
+
+private:
+    static constexpr int subBucketBits = 5;
+    static constexpr int subBucketCount = 1 << subBucketBits;
+    static constexpr int numBuckets = (32 - subBucketBits + 1) * subBucketCount;
+
+    static int getBucket(juce::uint32 value) noexcept
+    {
+        if (value < 2 * subBucketCount)
+            return static_cast<int>(value);
+
+        const auto shift = juce::findHighestSetBit(value) - subBucketBits;
+        return (shift + 1) * subBucketCount + static_cast<int>(value >> shift) - subBucketCount;
+    }
+
+    static juce::uint32 getBucketHighest(int bucket) noexcept
+    {
+        if (bucket < 2 * subBucketCount)
+            return static_cast<juce::uint32>(bucket);
+
+        const auto shift = bucket / subBucketCount - 1;
+        const auto lowest = static_cast<juce::uint64>(bucket % subBucketCount + subBucketCount) << shift;
+        return static_cast<juce::uint32>(lowest + (juce::uint64 { 1 } << shift) - 1);
+    }
+
+    std::array<juce::uint64, numBuckets> counts {};
+    juce::uint64 count = 0;
+    juce::uint64 total = 0;
+    juce::uint32 minimum = 0xffffffffu;
+    juce::uint32 maximum = 0;
+};
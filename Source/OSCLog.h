@@ -0,0 +1,469 @@
+/*
+  ==============================================================================
+
+    OSCLog.h
+    Structured logging that is cheap and safe enough for the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <iterator>
+#include <vector>
+
+// A log call writes a fixed-size binary record (timestamp, event id and up
+// to four integer arguments) into a ring owned by the calling thread: no
+// locks, no allocation, no formatting, a few tens of nanoseconds. The text
+// for each event lives in a table; OSCLogWriter's thread turns records into
+// lines and appends them to a file (and, in debug builds, the debugger
+// output) in the background.
+//
+// A thread claims a ring on its first log call by scanning for its thread
+// id, so there is no thread_local storage (which a plugin binary may only
+// get by allocating). Long-lived threads the plugin owns hand their ring
+// back with releaseThread() when they finish. Host threads never say when
+// they are done, so the writer takes back any ring that has had nothing
+// written to it for a few seconds; if its thread logs again, it simply
+// claims a free ring. Only more than maxThreads threads logging within that
+// time can run out of rings. Then, or when a ring is full because the
+// writer is not keeping up, records are dropped and counted, never waited
+// for.
+//
+// The level is a single atomic and can be changed at any time: with
+// setLevel(), the OSC_CLIENT_LOG_LEVEL environment variable at startup
+// (trace, debug, info, warning, error or off) or "/client/log_level ,i"
+// from the server.
+namespace OSCLog
+{
+    enum class Level : juce::uint8 { trace, debug, info, warning, error, off };
+
+    // Everything the hot paths log. The arguments are referred to as {0} to
+    // {3} in the format.
+    enum class Event : juce::uint16
+    {
+        packetSent,
+        sendFailed,
+        eventSkippedNoTags,
+        encodeFailed,
+        blockTruncated,
+        queueOverflow,
+        incomingMidiDropped,
+        multicastReceived,
+        multicastMalformed,
+        catalogueSnapshotInstalled,
+        catalogueDeltaGap,
+        tagHandleAssigned,
+        tagRegistrationUnanswered,
+        tagHandleExpired,
+        levelChanged,
+        recordsDropped,
+        numEvents
+    };
+
+    struct EventInfo
+    {
+        Level level;
+        const char* format;
+    };
+
+    inline const EventInfo& getEventInfo(Event event) noexcept
+    {
+        static constexpr EventInfo infos[] =
+        {
+            { Level::trace,   "Sent {0} bytes to port {1}" },
+            { Level::warning, "Failed to send {0} bytes to port {1}" },
+            { Level::debug,   "Skipping event: no tags configured to target an instrument" },
+            { Level::warning, "Failed to encode event with status {0} ({1} bytes written)" },
+            { Level::warning, "Dropped {0} events from block {1}: more than {2} in one block" },
+            { Level::warning, "Event queue full: dropped {0} events from block {1}" },
+            { Level::warning, "Incoming MIDI backlog full: dropped an event" },
+            { Level::trace,   "Received {0} bytes from the multicast group: {1} message(s)" },
+            { Level::warning, "Ignoring malformed multicast datagram ({0} bytes)" },
+            { Level::info,    "Installing catalogue snapshot {0}: {1} tags" },
+            { Level::info,    "Catalogue delta {0} does not follow version {1}; requesting a snapshot" },
+            { Level::info,    "Server assigned tag handle {0}" },
+            { Level::warning, "Server did not acknowledge tag registration; using string tags" },
+            { Level::info,    "Tag handle expired; falling back to string tags" },
+            { Level::info,    "Log level set to {0} (0 trace, 1 debug, 2 info, 3 warning, 4 error, 5 off)" },
+            { Level::warning, "Dropped {0} log records" },
+        };
+
+        static_assert(std::size(infos) == static_cast<size_t>(Event::numEvents), "Every event needs a format");
+        return infos[static_cast<size_t>(event)];
+    }
+
+    inline const char* getLevelName(Level level) noexcept
+    {
+        static constexpr const char* names[] = { "trace", "debug", "info", "warning", "error", "off" };
+        return names[juce::jlimit(0, 5, static_cast<int>(level))];
+    }
+
+    //==============================================================================
+    constexpr int maxArguments = 4;
+    constexpr int maxThreads = 16;
+    constexpr int ringCapacity = 1024;      // a power of two
+
+    struct Record
+    {
+        juce::int64 ticks = 0;              // juce::Time::getHighResolutionTicks()
+        Event event = Event::packetSent;
+        juce::uint8 numArguments = 0;
+        juce::int64 arguments[maxArguments] {};
+    };
+
+    // Owner of a ring while the writer takes it back
+    inline char reclaimMarker = 0;
+
+    // Single producer (the owning thread), single consumer (the writer)
+    struct Ring
+    {
+        std::atomic<void*> owner { nullptr };
+        std::atomic<int> numWriting { 0 };          // threads between enter() and exit()
+        std::atomic<juce::uint32> head { 0 };       // written by the producer
+        std::atomic<juce::uint32> tail { 0 };       // written by the consumer
+        std::atomic<juce::uint64> numDropped { 0 };
+        Record records[ringCapacity] {};
+
+        bool push(const Record& record) noexcept
+        {
+            const auto position = head.load(std::memory_order_relaxed);
+
+            if (position - tail.load(std::memory_order_acquire) >= static_cast<juce::uint32>(ringCapacity))
+            {
+                numDropped.store(numDropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            records[position & (ringCapacity - 1)] = record;
+            head.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        template <typename Callback>
+        void popAll(Callback&& callback)
+        {
+            const auto end = head.load(std::memory_order_acquire);
+            auto position = tail.load(std::memory_order_relaxed);
+
+            for (; position != end; ++position)
+                callback(records[position & (ringCapacity - 1)]);
+
+            tail.store(position, std::memory_order_release);
+        }
+
+        // Producer side: announces a write, then checks that the ring is still
+        // this thread's. Together with tryReclaim() checking the other way
+        // round, at most one of them succeeds.
+        bool enter(void* thread) noexcept
+        {
+            numWriting.fetch_add(1);
+
+            if (owner.load() == thread)
+                return true;
+
+            numWriting.fetch_sub(1);
+            return false;
+        }
+
+        void exit() noexcept
+        {
+            numWriting.fetch_sub(1, std::memory_order_release);
+        }
+
+        // Writer side: takes the ring from its owner unless it is writing.
+        // On success the owner is reclaimMarker until finishReclaim().
+        bool tryReclaim() noexcept
+        {
+            auto* current = owner.load();
+
+            if (current == nullptr || current == &reclaimMarker
+                 || !owner.compare_exchange_strong(current, &reclaimMarker))
+                return false;
+
+            if (numWriting.load() == 0)
+                return true;
+
+            owner.store(current);
+            return false;
+        }
+
+        void finishReclaim() noexcept
+        {
+            owner.store(nullptr);
+        }
+    };
+
+    inline Ring rings[maxThreads];
+    inline std::atomic<juce::uint64> numDroppedWithoutRing { 0 };
+
+   #if JUCE_DEBUG
+    inline std::atomic<Level> currentLevel { Level::debug };
+   #else
+    inline std::atomic<Level> currentLevel { Level::warning };
+   #endif
+
+    inline Level getLevel() noexcept         { return currentLevel.load(std::memory_order_relaxed); }
+    inline bool isEnabled(Level level) noexcept  { return level >= getLevel() && level != Level::off; }
+
+    inline bool parseLevel(const juce::String& name, Level& level) noexcept
+    {
+        for (int i = 0; i <= static_cast<int>(Level::off); ++i)
+        {
+            if (name.equalsIgnoreCase(getLevelName(static_cast<Level>(i))))
+            {
+                level = static_cast<Level>(i);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Returns the calling thread's ring, claiming a free one if needed, with
+    // enter() already called on it
+    inline Ring* enterRingForThisThread() noexcept
+    {
+        auto* const thisThread = juce::Thread::getCurrentThreadId();
+
+        for (auto& ring : rings)
+            if (ring.owner.load(std::memory_order_relaxed) == thisThread && ring.enter(thisThread))
+                return &ring;
+
+        for (auto& ring : rings)
+        {
+            void* expected = nullptr;
+
+            if (ring.owner.compare_exchange_strong(expected, thisThread) && ring.enter(thisThread))
+                return &ring;
+        }
+
+        return nullptr;
+    }
+
+    // Real-time safe
+    template <typename... Arguments>
+    void write(Event event, Arguments... arguments) noexcept
+    {
+        static_assert(sizeof...(Arguments) <= maxArguments, "Too many log arguments");
+
+        if (!isEnabled(getEventInfo(event).level))
+            return;
+
+        Record record;
+        record.ticks = juce::Time::getHighResolutionTicks();
+        record.event = event;
+        record.numArguments = static_cast<juce::uint8>(sizeof...(Arguments));
+
+        int index = 0;
+        ((record.arguments[index++] = static_cast<juce::int64>(arguments)), ...);
+        juce::ignoreUnused(index);
+
+        if (auto* ring = enterRingForThisThread())
+        {
+            ring->push(record);
+            ring->exit();
+        }
+        else
+            numDroppedWithoutRing.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline void setLevel(Level level) noexcept
+    {
+        if (currentLevel.exchange(level, std::memory_order_relaxed) != level)
+            write(Event::levelChanged, static_cast<int>(level));
+    }
+
+    // Hands the calling thread's ring back; records still in it are written
+    inline void releaseThread() noexcept
+    {
+        auto* const thisThread = juce::Thread::getCurrentThreadId();
+
+        for (auto& ring : rings)
+        {
+            void* expected = thisThread;
+
+            if (ring.owner.compare_exchange_strong(expected, nullptr))
+                return;
+        }
+    }
+
+    inline juce::String format(const Record& record)
+    {
+        const auto* text = getEventInfo(record.event).format;
+        juce::String result;
+
+        for (; *text != 0; ++text)
+        {
+            const auto index = text[1] - '0';
+
+            if (text[0] == '{' && index >= 0 && index < record.numArguments && text[2] == '}')
+            {
+                result << record.arguments[index];
+                text += 2;
+            }
+            else
+            {
+                result += *text;
+            }
+        }
+
+        return result;
+    }
+}
+
+//==============================================================================
+// Drains every ring a few times a second, in timestamp order, into the log
+// file. One is enough for the process; the transport hub owns it.
+class OSCLogWriter : private juce::Thread
+{
+public:
+    OSCLogWriter()
+        : juce::Thread("OSC Log"),
+          logFile(getDefaultFile()),
+          startTicks(juce::Time::getHighResolutionTicks()),
+          startMillis(juce::Time::currentTimeMillis())
+    {
+        OSCLog::Level level;
+
+        if (OSCLog::parseLevel(juce::SystemStats::getEnvironmentVariable("OSC_CLIENT_LOG_LEVEL", {}), level))
+            OSCLog::setLevel(level);
+
+        startThread(juce::Thread::Priority::background);
+    }
+
+    ~OSCLogWriter() override
+    {
+        stopThread(1000);
+        drain();
+    }
+
+    static juce::File getDefaultFile()
+    {
+        return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                   .getChildFile("OSC_Client")
+                   .getChildFile("OSC_Client.log");
+    }
+
+private:
+    static constexpr int drainIntervalMs = 100;
+    static constexpr int reclaimAfterIdleDrains = 50;
+    static constexpr juce::int64 maxFileSize = 4 * 1024 * 1024;
+
+    struct Entry
+    {
+        OSCLog::Record record;
+        int thread;
+    };
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            drain();
+            wait(drainIntervalMs);
+        }
+    }
+
+    void drain()
+    {
+        entries.clear();
+
+        for (int i = 0; i < OSCLog::maxThreads; ++i)
+        {
+            auto& ring = OSCLog::rings[i];
+            const auto reclaimed = isIdle(i) && ring.tryReclaim();
+
+            ring.popAll([this, i](const OSCLog::Record& record) { entries.push_back({ record, i }); });
+
+            if (reclaimed)
+                ring.finishReclaim();
+        }
+
+        const auto numDropped = countDropped();
+
+        if (entries.empty() && numDropped == 0)
+            return;
+
+        std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.record.ticks < b.record.ticks; });
+
+        juce::String text;
+
+        for (const auto& entry : entries)
+            text << formatLine(entry.record, entry.thread);
+
+        if (numDropped > 0)
+        {
+            OSCLog::Record record;
+            record.ticks = juce::Time::getHighResolutionTicks();
+            record.event = OSCLog::Event::recordsDropped;
+            record.numArguments = 1;
+            record.arguments[0] = static_cast<juce::int64>(numDropped);
+            text << formatLine(record, -1);
+        }
+
+       #if JUCE_DEBUG
+        juce::Logger::outputDebugString(text.trimEnd());
+       #endif
+
+        if (logFile.getSize() > maxFileSize)
+            logFile.moveFileTo(logFile.withFileExtension("1.log"));
+
+        if (!logFile.getParentDirectory().createDirectory() || !logFile.appendText(text, false, false, "\n"))
+            DBG("Failed to write to " << logFile.getFullPathName());
+    }
+
+    // True once a claimed ring has had nothing written to it for
+    // reclaimAfterIdleDrains drains in a row
+    bool isIdle(int index)
+    {
+        const auto& ring = OSCLog::rings[index];
+        const auto head = ring.head.load(std::memory_order_relaxed);
+        auto& idle = ringIdleDrains[(size_t) index];
+
+        if (ring.owner.load(std::memory_order_relaxed) == nullptr || head != ringHeads[(size_t) index])
+            idle = 0;
+        else
+            ++idle;
+
+        ringHeads[(size_t) index] = head;
+        return idle >= reclaimAfterIdleDrains;
+    }
+
+    juce::uint64 countDropped()
+    {
+        juce::uint64 total = OSCLog::numDroppedWithoutRing.load(std::memory_order_relaxed);
+
+        for (const auto& ring : OSCLog::rings)
+            total += ring.numDropped.load(std::memory_order_relaxed);
+
+        const auto numNew = total - numDroppedReported;
+        numDroppedReported = total;
+        return numNew;
+    }
+
+    juce::String formatLine(const OSCLog::Record& record, int thread) const
+    {
+        const auto elapsedMillis = juce::Time::highResolutionTicksToSeconds(record.ticks - startTicks) * 1000.0;
+        const juce::Time time(startMillis + static_cast<juce::int64>(elapsedMillis));
+
+        return time.formatted("%Y-%m-%d %H:%M:%S.") + juce::String(time.getMilliseconds()).paddedLeft('0', 3)
+             + " [" + OSCLog::getLevelName(OSCLog::getEventInfo(record.event).level) + "]"
+             + (thread >= 0 ? " t" + juce::String(thread) : juce::String()) + " "
+             + OSCLog::format(record) + "\n";
+    }
+
+    const juce::File logFile;
+    const juce::int64 startTicks;
+    const juce::int64 startMillis;
+    std::vector<Entry> entries;
+    juce::uint64 numDroppedReported = 0;
+    std::array<juce::uint32, OSCLog::maxThreads> ringHeads {};
+    std::array<int, OSCLog::maxThreads> ringIdleDrains {};
+
+    JUCE_DECLARE_NON_COPYABLE(OSCLogWriter)
+};
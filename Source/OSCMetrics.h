@@ -0,0 +1,147 @@
+/*
+  ==============================================================================
+
+    OSCMetrics.h
+    Per-instance counters and latency histograms for the send and receive
+    paths, cheap enough to update on the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+// Each counter and histogram has exactly one writing thread (the audio
+// thread or the transport thread), so updates are a relaxed load and store
+// with no read-modify-write, and each sits on its own cache line so that the
+// two writers never contend for one. Any thread can read them at any time;
+// a reading is a consistent count, not a consistent set of counts.
+static constexpr size_t metricsCacheLineSize = 64;
+
+class alignas(metricsCacheLineSize) OSCMetricCounter
+{
+public:
+    // Writing thread only
+    void add(juce::uint64 amount = 1) noexcept
+    {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    juce::uint64 get() const noexcept  { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<juce::uint64> value { 0 };
+};
+
+// Microsecond timings in power-of-two buckets: bucket 0 holds 0, bucket i
+// holds [2^(i-1), 2^i). Coarse, but fixed-size, allocation-free and enough
+// to tell 100 us from 1 ms from 10 ms.
+class alignas(metricsCacheLineSize) OSCMetricHistogram
+{
+public:
+    static constexpr int numBuckets = 33;
+
+    struct Snapshot
+    {
+        std::array<juce::uint64, numBuckets> counts {};
+        juce::uint64 count = 0;
+        juce::uint32 maximum = 0;
+
+        // The upper edge of the bucket holding the percentile (0-100), capped
+        // at the largest value recorded
+        juce::uint32 getPercentile(double percentile) const noexcept
+        {
+            if (count == 0)
+                return 0;
+
+            const auto rank = juce::jmax<juce::uint64>(1, static_cast<juce::uint64>(percentile / 100.0 * static_cast<double>(count) + 0.5));
+            juce::uint64 seen = 0;
+
+            for (int i = 0; i < numBuckets; ++i)
+            {
+                seen += counts[static_cast<size_t>(i)];
+
+                if (seen >= rank)
+                    return juce::jmin(maximum, getBucketHighest(i));
+            }
+
+            return maximum;
+        }
+    };
+
+    // Writing thread only
+    void record(juce::uint32 micros) noexcept
+    {
+        auto& bucket = buckets[static_cast<size_t>(getBucket(micros))];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (micros > maximum.load(std::memory_order_relaxed))
+            maximum.store(micros, std::memory_order_relaxed);
+    }
+
+    Snapshot getSnapshot() const noexcept
+    {
+        Snapshot snapshot;
+
+        for (size_t i = 0; i < buckets.size(); ++i)
+        {
+            snapshot.counts[i] = buckets[i].load(std::memory_order_relaxed);
+            snapshot.count += snapshot.counts[i];
+        }
+
+        snapshot.maximum = maximum.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+private:
+    static int getBucket(juce::uint32 micros) noexcept
+    {
+        return micros == 0 ? 0 : juce::findHighestSetBit(micros) + 1;
+    }
+
+    static juce::uint32 getBucketHighest(int bucket) noexcept
+    {
+        return bucket == 0 ? 0 : static_cast<juce::uint32>((juce::uint64 { 1 } << bucket) - 1);
+    }
+
+    std::array<std::atomic<juce::uint64>, numBuckets> buckets {};
+    std::atomic<juce::uint32> maximum { 0 };
+};
+
+// What one plugin instance has done since it was created
+struct OSCClientMetrics
+{
+    // Audio thread
+    OSCMetricCounter eventsIn;                  // notes and controllers taken from the host's MIDI
+    OSCMetricCounter eventsTruncated;           // dropped past maxEventsPerBlock, before or after coalescing
+    OSCMetricHistogram processBlockMicros;      // time spent in processBlock
+
+    // Transport thread
+    OSCMetricCounter messagesOut;               // encoded and handed to a socket or bundle
+    OSCMetricCounter bytesOut;                  // of those messages, before bundling
+    OSCMetricCounter sendFailures;              // datagrams the socket refused, including bundles carrying our messages
+    OSCMetricCounter encodeFailures;            // events that did not fit into a packet
+    OSCMetricCounter datagramsReceived;         // from the server this instance sends to
+    OSCMetricCounter parseErrors;               // of those, ones that were not valid OSC
+    OSCMetricHistogram queueLatencyMicros;      // from processBlock to the socket or bundle
+
+    // Everything above plus the counters kept elsewhere, read in one go
+    struct Snapshot
+    {
+        juce::uint64 eventsIn = 0;
+        juce::uint64 eventsCoalesced = 0;       // controller values thinned out
+        juce::uint64 queueOverflows = 0;        // events dropped because the queue was full
+        juce::uint64 eventsTruncated = 0;
+        juce::uint64 messagesOut = 0;
+        juce::uint64 bytesOut = 0;
+        juce::uint64 sendFailures = 0;
+        juce::uint64 encodeFailures = 0;
+        juce::uint64 datagramsReceived = 0;
+        juce::uint64 parseErrors = 0;
+        OSCMetricHistogram::Snapshot processBlockMicros;
+        OSCMetricHistogram::Snapshot queueLatencyMicros;
+    };
+};
@@ -0,0 +1,327 @@
+/*
+  ==============================================================================
+
+    OSCParser.h
+    Zero-copy, bounds-checked parsing of OSC packets received from the server.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstring>
+#include <string_view>
+
+// One argument of a parsed message. It points into the datagram it came
+// from, so it is only valid while that buffer is; values are decoded from
+// the big-endian bytes when asked for.
+struct OSCArgument
+{
+    char type = 0;
+    const char* data = nullptr;
+    size_t size = 0;
+
+    bool isInt32() const noexcept    { return type == 'i'; }
+    bool isFloat32() const noexcept  { return type == 'f'; }
+    bool isString() const noexcept   { return type == 's' || type == 'S'; }
+    bool isBlob() const noexcept     { return type == 'b'; }
+    bool isTimeTag() const noexcept  { return type == 't'; }
+    bool isMidi() const noexcept     { return type == 'm'; }
+
+    juce::int32 getInt32() const noexcept      { return static_cast<juce::int32>(juce::ByteOrder::bigEndianInt(data)); }
+    juce::int64 getInt64() const noexcept      { return static_cast<juce::int64>(juce::ByteOrder::bigEndianInt64(data)); }
+    juce::uint64 getTimeTag() const noexcept   { return static_cast<juce::uint64>(juce::ByteOrder::bigEndianInt64(data)); }
+    const juce::uint8* getMidi() const noexcept { return reinterpret_cast<const juce::uint8*>(data); }
+
+    float getFloat32() const noexcept
+    {
+        const auto bits = juce::ByteOrder::bigEndianInt(data);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    double getFloat64() const noexcept
+    {
+        const auto bits = juce::ByteOrder::bigEndianInt64(data);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // Without the terminator or padding
+    std::string_view getString() const noexcept  { return { data, size }; }
+
+    // Just the blob bytes, after the size prefix
+    const char* getBlobData() const noexcept  { return data + 4; }
+    size_t getBlobSize() const noexcept       { return size; }
+
+    bool getBool() const noexcept  { return type == 'T'; }
+};
+
+namespace OSCParser
+{
+    // Reads an OSC-string at offset: a run of bytes ending in a NUL, padded to
+    // a multiple of four. Fails rather than reading past size.
+    inline bool readString(const char* data, size_t size, size_t& offset, std::string_view& result) noexcept
+    {
+        if (offset >= size)
+            return false;
+
+        const auto* start = data + offset;
+        const auto* terminator = static_cast<const char*>(std::memchr(start, 0, size - offset));
+
+        if (terminator == nullptr)
+            return false;
+
+        const auto length = static_cast<size_t>(terminator - start);
+        const auto paddedLength = (length + 4) & ~static_cast<size_t>(3);
+
+        if (paddedLength > size - offset)
+            return false;
+
+        result = std::string_view(start, length);
+        offset += paddedLength;
+        return true;
+    }
+
+    // Reads the argument of the given type at offset, or fails if it is an
+    // unknown type or runs past size
+    inline bool readArgument(char type, const char* data, size_t size, size_t& offset, OSCArgument& argument) noexcept
+    {
+        argument.type = type;
+        argument.data = data + offset;
+        argument.size = 0;
+
+        const auto remaining = offset <= size ? size - offset : 0;
+
+        switch (type)
+        {
+            case 'i': case 'f': case 'c': case 'r': case 'm':
+                if (remaining < 4)
+                    return false;
+
+                argument.size = 4;
+                offset += 4;
+                return true;
+
+            case 'h': case 't': case 'd':
+                if (remaining < 8)
+                    return false;
+
+                argument.size = 8;
+                offset += 8;
+                return true;
+
+            case 's': case 'S':
+            {
+                std::string_view string;
+
+                if (!readString(data, size, offset, string))
+                    return false;
+
+                argument.size = string.size();
+                return true;
+            }
+
+            case 'b':
+            {
+                if (remaining < 4)
+                    return false;
+
+                const auto blobSize = static_cast<juce::int32>(juce::ByteOrder::bigEndianInt(data + offset));
+
+                if (blobSize < 0)
+                    return false;
+
+                const auto paddedSize = (static_cast<size_t>(blobSize) + 3) & ~static_cast<size_t>(3);
+
+                if (paddedSize > remaining - 4)
+                    return false;
+
+                argument.size = static_cast<size_t>(blobSize);
+                offset += 4 + paddedSize;
+                return true;
+            }
+
+            // No data: true, false, nil, infinitum and array brackets
+            case 'T': case 'F': case 'N': case 'I': case '[': case ']':
+                return true;
+
+            default:
+                return false;
+        }
+    }
+}
+
+// A view of one OSC message inside a datagram. parse() validates the whole
+// message in a single pass without allocating; after that the arguments can
+// be iterated with no further checks. Nothing is copied, so the view is only
+// valid while the datagram buffer is.
+class OSCMessageView
+{
+public:
+    OSCMessageView() = default;
+
+    // Returns false for anything that is not exactly one well-formed message
+    bool parse(const char* data, size_t size) noexcept
+    {
+        *this = {};
+
+        if (data == nullptr || size == 0 || size % 4 != 0 || data[0] != '/')
+            return false;
+
+        size_t offset = 0;
+        std::string_view addressPattern, tags;
+
+        if (!OSCParser::readString(data, size, offset, addressPattern)
+            || !OSCParser::readString(data, size, offset, tags)
+            || tags.empty() || tags[0] != ',')
+            return false;
+
+        const auto firstArgumentOffset = offset;
+
+        for (size_t i = 1; i < tags.size(); ++i)
+        {
+            OSCArgument argument;
+
+            if (!OSCParser::readArgument(tags[i], data, size, offset, argument))
+                return false;
+        }
+
+        if (offset != size)
+            return false;
+
+        messageData = data;
+        messageSize = size;
+        argumentsOffset = firstArgumentOffset;
+        address = addressPattern;
+        typeTags = tags.substr(1);
+        return true;
+    }
+
+    bool isValid() const noexcept                   { return messageData != nullptr; }
+    std::string_view getAddress() const noexcept    { return address; }
+    std::string_view getTypeTags() const noexcept   { return typeTags; }   // without the leading comma
+    int getNumArguments() const noexcept            { return static_cast<int>(typeTags.size()); }
+
+    bool hasAddress(std::string_view other) const noexcept   { return address == other; }
+    bool hasTypeTags(std::string_view other) const noexcept  { return typeTags == other; }
+
+    //==============================================================================
+    class Iterator
+    {
+    public:
+        Iterator(const OSCMessageView& viewToUse, size_t tagIndex, size_t dataOffset) noexcept
+            : view(&viewToUse), index(tagIndex), offset(dataOffset)
+        {
+            read();
+        }
+
+        const OSCArgument& operator*() const noexcept   { return current; }
+        const OSCArgument* operator->() const noexcept  { return &current; }
+
+        Iterator& operator++() noexcept
+        {
+            ++index;
+            read();
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const noexcept  { return index == other.index; }
+        bool operator!=(const Iterator& other) const noexcept  { return index != other.index; }
+
+    private:
+        void read() noexcept
+        {
+            // Already validated by parse(), so this cannot fail
+            if (index < view->typeTags.size())
+                OSCParser::readArgument(view->typeTags[index], view->messageData, view->messageSize, offset, current);
+        }
+
+        const OSCMessageView* view;
+        size_t index;
+        size_t offset;
+        OSCArgument current;
+    };
+
+    Iterator begin() const noexcept  { return Iterator(*this, 0, argumentsOffset); }
+    Iterator end() const noexcept    { return Iterator(*this, typeTags.size(), messageSize); }
+
+private:
+    const char* messageData = nullptr;
+    size_t messageSize = 0;
+    size_t argumentsOffset = 0;
+    std::string_view address;
+    std::string_view typeTags;
+};
+
+namespace OSCParser
+{
+    // Nesting deeper than this is treated as malformed rather than recursed into
+    constexpr int maxBundleDepth = 8;
+
+    // Time tag given to messages that are not inside any bundle
+    constexpr juce::uint64 immediateTimeTag = 1;
+
+    inline bool isBundle(const char* data, size_t size) noexcept
+    {
+        return size >= 16 && std::memcmp(data, "#bundle", 8) == 0;
+    }
+
+    // Calls handleMessage(const OSCMessageView&, juce::uint64 timeTag) for every
+    // message in a packet, recursing into nested bundles; each message gets
+    // the time tag of the innermost bundle holding it. Stops and returns false
+    // at the first malformed element, so to handle a packet all-or-nothing
+    // call validatePacket() first.
+    template <typename Handler>
+    bool forEachMessage(const char* data, size_t size, Handler&& handleMessage,
+                        juce::uint64 timeTag = immediateTimeTag, int depth = 0)
+    {
+        if (size == 0 || size % 4 != 0)
+            return false;
+
+        if (!isBundle(data, size))
+        {
+            OSCMessageView message;
+
+            if (!message.parse(data, size))
+                return false;
+
+            handleMessage(message, timeTag);
+            return true;
+        }
+
+        if (depth >= maxBundleDepth)
+            return false;
+
+        const auto bundleTimeTag = static_cast<juce::uint64>(juce::ByteOrder::bigEndianInt64(data + 8));
+        size_t offset = 16;
+
+        while (offset < size)
+        {
+            if (size - offset < 4)
+                return false;
+
+            const auto elementSize = static_cast<juce::int32>(juce::ByteOrder::bigEndianInt(data + offset));
+            offset += 4;
+
+            if (elementSize <= 0 || static_cast<size_t>(elementSize) > size - offset)
+                return false;
+
+            if (!forEachMessage(data + offset, static_cast<size_t>(elementSize), handleMessage, bundleTimeTag, depth + 1))
+                return false;
+
+            offset += static_cast<size_t>(elementSize);
+        }
+
+        return true;
+    }
+
+    // Checks a whole packet (message or bundle, at any depth) without handling it
+    inline bool validatePacket(const char* data, size_t size) noexcept
+    {
+        return forEachMessage(data, size, [](const OSCMessageView&, juce::uint64) {});
+    }
+}
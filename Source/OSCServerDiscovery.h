@@ -0,0 +1,289 @@
+/*
+  ==============================================================================
+
+    OSCServerDiscovery.h
+    The servers announcing themselves on the multicast group, with the round
+    trip time to each.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include "OSCEncoder.h"
+#include "OSCParser.h"
+
+// Servers announce themselves on the multicast group every second or so:
+//
+//   /server/announce ,si    name, OSC port
+//   /server/announce ,sis   name, OSC port, host (when the source address
+//                           of the datagram is not the one to send to)
+//
+// While at least one instance picks its server automatically, the transport
+// thread pings every live server once a second ("/server/ping ,i nonce") on
+// a socket used for nothing else, and the server answers "/server/pong ,i
+// nonce" to it; the round trip is smoothed into rttMs. A server that has not
+// announced for a few seconds is dropped.
+//
+// Announcements arrive on the multicast thread, pings and pongs are handled
+// on the transport thread and instances ask for a server from either that
+// thread or the message thread, so the table is behind a lock. None of it
+// runs on the audio thread.
+struct OSCServerInfo
+{
+    juce::String name;
+    juce::String host;
+    int port = 0;
+
+    double rttMs = -1.0;        // negative until the first pong
+    double lastAnnounceMs = 0.0;
+    double lastPingMs = 0.0;
+    juce::int32 pingNonce = 0;
+    bool awaitingPong = false;
+};
+
+class OSCServerDirectory
+{
+public:
+    // The group servers announce on (and broadcast their tag catalogue to)
+    static constexpr const char* multicastGroup = "239.255.0.1";
+    static constexpr int multicastPort = 9000;
+
+    static constexpr const char* announceAddress = "/server/announce";
+    static constexpr const char* pingAddress = "/server/ping";
+    static constexpr const char* pongAddress = "/server/pong";
+
+    static constexpr double pingIntervalMs = 1000.0;
+    static constexpr double expiryMs = 5000.0;
+
+    struct Endpoint
+    {
+        juce::String host;
+        int port = 0;
+    };
+
+    // Multicast thread: a datagram from senderAddress announced a server
+    void handleAnnouncement(const OSCMessageView& message, const juce::String& senderAddress, double nowMs)
+    {
+        if (!message.hasTypeTags("si") && !message.hasTypeTags("sis"))
+            return;
+
+        auto argument = message.begin();
+        const auto name = toString(*argument);
+        const auto port = (++argument)->getInt32();
+        const auto host = message.getNumArguments() == 3 ? toString(*++argument) : senderAddress;
+
+        if (name.isEmpty() || host.isEmpty() || port <= 0 || port > 65535)
+            return;
+
+        const juce::ScopedLock sl(lock);
+
+        for (auto& server : servers)
+        {
+            if (server.name == name)
+            {
+                if (server.host != host || server.port != port)
+                {
+                    DBG("Server " << name << " moved to " << host << ":" << port);
+                    server.host = host;
+                    server.port = port;
+                    server.rttMs = -1.0;
+                    server.awaitingPong = false;
+                    ++generation;
+                }
+
+                server.lastAnnounceMs = nowMs;
+                return;
+            }
+        }
+
+        DBG("Discovered server " << name << " at " << host << ":" << port);
+
+        OSCServerInfo server;
+        server.name = name;
+        server.host = host;
+        server.port = port;
+        server.lastAnnounceMs = nowMs;
+        servers.push_back(server);
+        ++generation;
+    }
+
+    // Transport thread: drops servers that have gone quiet and, if
+    // shouldPing, pings the rest when due, calling send(host, port, data,
+    // size) for each ping
+    template <typename Send>
+    void servicePings(double nowMs, bool shouldPing, Send&& send)
+    {
+        const juce::ScopedLock sl(lock);
+
+        const auto expired = std::remove_if(servers.begin(), servers.end(),
+                                            [nowMs](const OSCServerInfo& server) { return nowMs - server.lastAnnounceMs > expiryMs; });
+
+        if (expired != servers.end())
+        {
+            for (auto it = expired; it != servers.end(); ++it)
+                DBG("Server " << it->name << " stopped announcing");
+
+            servers.erase(expired, servers.end());
+            ++generation;
+        }
+
+        if (!shouldPing)
+            return;
+
+        for (auto& server : servers)
+        {
+            // New servers are pinged straight away
+            if (server.lastPingMs > 0.0 && nowMs - server.lastPingMs < pingIntervalMs)
+                continue;
+
+            server.pingNonce = nonceGenerator.nextInt();
+            server.lastPingMs = nowMs;
+            server.awaitingPong = true;
+
+            char buffer[32];
+            OSCPacketWriter writer(buffer, sizeof(buffer));
+            writer.writeString(pingAddress);
+            writer.writeString(",i");
+            writer.writeInt32(server.pingNonce);
+
+            if (!writer.hasOverflowed())
+                send(server.host, server.port, writer.getData(), writer.getSize());
+        }
+    }
+
+    // Transport thread: a datagram arrived on the ping socket. Only the
+    // pinged server knows the nonce, so that is all a pong is matched on.
+    void handlePong(const OSCMessageView& message, double nowMs)
+    {
+        if (!message.hasAddress(pongAddress) || !message.hasTypeTags("i"))
+            return;
+
+        const auto nonce = message.begin()->getInt32();
+        const juce::ScopedLock sl(lock);
+
+        for (auto& server : servers)
+        {
+            if (server.awaitingPong && server.pingNonce == nonce)
+            {
+                const auto previousMs = server.rttMs;
+                const auto sampleMs = nowMs - server.lastPingMs;
+                server.rttMs = previousMs < 0.0 ? sampleMs : previousMs + rttSmoothing * (sampleMs - previousMs);
+                server.awaitingPong = false;
+
+                // Most pongs only nudge an RTT; instances need to choose
+                // again only if that can change what select() picks
+                if (previousMs < 0.0 || changesStanding(server, previousMs))
+                    ++generation;
+
+                break;
+            }
+        }
+    }
+
+    // Picks the server called name or, if name is empty, the one with the
+    // lowest round trip. To avoid hopping between servers on jitter, current
+    // is kept unless another is clearly faster. Returns false if no suitable
+    // server is live.
+    bool select(const juce::String& name, const Endpoint* current, Endpoint& result) const
+    {
+        const juce::ScopedLock sl(lock);
+        const OSCServerInfo* best = nullptr;
+        const OSCServerInfo* currentServer = nullptr;
+
+        for (const auto& server : servers)
+        {
+            if (name.isNotEmpty())
+            {
+                if (server.name == name)
+                {
+                    best = &server;
+                    break;
+                }
+
+                continue;
+            }
+
+            if (current != nullptr && server.host == current->host && server.port == current->port)
+                currentServer = &server;
+
+            // Servers not yet measured rank after measured ones
+            if (best == nullptr || rankBefore(server, *best))
+                best = &server;
+        }
+
+        if (best == nullptr)
+            return false;
+
+        if (currentServer != nullptr && currentServer->rttMs >= 0.0 && best->rttMs >= 0.0
+            && currentServer->rttMs <= best->rttMs * switchRatio + switchMarginMs)
+            best = currentServer;
+
+        result.host = best->host;
+        result.port = best->port;
+        return true;
+    }
+
+    std::vector<OSCServerInfo> getServers() const
+    {
+        const juce::ScopedLock sl(lock);
+        return servers;
+    }
+
+    // Changes whenever a server appears, moves or goes, or its RTT moves it
+    // past another server, so callers can skip select() when nothing they
+    // would pick has changed
+    juce::uint32 getGeneration() const noexcept  { return generation.load(); }
+
+private:
+    static constexpr double rttSmoothing = 0.25;
+    static constexpr double switchRatio = 1.2;
+    static constexpr double switchMarginMs = 0.5;
+
+    static juce::String toString(const OSCArgument& argument)
+    {
+        return juce::String::fromUTF8(argument.getString().data(), static_cast<int>(argument.size));
+    }
+
+    // How select() sees two measured round trips: 2 if a is clearly faster,
+    // -2 if b is, otherwise 1, 0 or -1 by which is lower
+    static int getStanding(double aMs, double bMs) noexcept
+    {
+        if (bMs > aMs * switchRatio + switchMarginMs)
+            return 2;
+
+        if (aMs > bMs * switchRatio + switchMarginMs)
+            return -2;
+
+        return aMs < bMs ? 1 : (aMs > bMs ? -1 : 0);
+    }
+
+    // Whether server's RTT going from previousMs to its current value changed
+    // its standing against any other measured server
+    bool changesStanding(const OSCServerInfo& server, double previousMs) const noexcept
+    {
+        for (const auto& other : servers)
+            if (&other != &server && other.rttMs >= 0.0
+                && getStanding(previousMs, other.rttMs) != getStanding(server.rttMs, other.rttMs))
+                return true;
+
+        return false;
+    }
+
+    static bool rankBefore(const OSCServerInfo& a, const OSCServerInfo& b) noexcept
+    {
+        if ((a.rttMs >= 0.0) != (b.rttMs >= 0.0))
+            return a.rttMs >= 0.0;
+
+        return a.rttMs < b.rttMs;
+    }
+
+    mutable juce::CriticalSection lock;
+    std::vector<OSCServerInfo> servers;
+    juce::Random nonceGenerator;
+    std::atomic<juce::uint32> generation { 0 };
+};
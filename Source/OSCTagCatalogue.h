@@ -0,0 +1,338 @@
+/*
+  ==============================================================================
+
+    OSCTagCatalogue.h
+    The server's instrument tag catalogue, kept up to date from versioned
+    snapshots and add/remove deltas.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <array>
+#include <map>
+#include <memory>
+#include <vector>
+#include "OSCLog.h"
+#include "OSCParser.h"
+
+// An immutable-by-sharing set of tags with a version. The tags are spread
+// over hash buckets, and buckets are shared between copies, so a copy is
+// cheap and applying a delta only copies the buckets it touches. That lets
+// the receive thread publish a new catalogue in every snapshot without
+// rebuilding thousands of strings.
+class OSCTagCatalogue
+{
+public:
+    static constexpr int numBuckets = 256;
+
+    using Bucket = std::vector<juce::String>;   // sorted
+
+    // False until the first full snapshot has been installed
+    bool isValid() const noexcept               { return valid; }
+    juce::uint32 getVersion() const noexcept    { return version; }
+    int size() const noexcept                   { return numTags; }
+
+    bool contains(const juce::String& tag) const
+    {
+        const auto& bucket = buckets[static_cast<size_t>(getBucketIndex(tag))];
+        return bucket != nullptr && std::binary_search(bucket->begin(), bucket->end(), tag);
+    }
+
+    // Every tag, sorted
+    juce::StringArray getTags() const
+    {
+        juce::StringArray tags;
+        tags.ensureStorageAllocated(numTags);
+
+        for (const auto& bucket : buckets)
+            if (bucket != nullptr)
+                for (const auto& tag : *bucket)
+                    tags.add(tag);
+
+        tags.sort(false);
+        return tags;
+    }
+
+    // Replaces everything with a full snapshot
+    void reset(juce::uint32 newVersion, const std::vector<juce::String>& tags)
+    {
+        std::array<Bucket, numBuckets> newBuckets;
+
+        for (const auto& tag : tags)
+            newBuckets[static_cast<size_t>(getBucketIndex(tag))].push_back(tag);
+
+        numTags = 0;
+
+        for (size_t i = 0; i < buckets.size(); ++i)
+        {
+            auto& bucket = newBuckets[i];
+            std::sort(bucket.begin(), bucket.end());
+            bucket.erase(std::unique(bucket.begin(), bucket.end()), bucket.end());
+
+            numTags += static_cast<int>(bucket.size());
+            buckets[i] = bucket.empty() ? nullptr : std::make_shared<const Bucket>(std::move(bucket));
+        }
+
+        version = newVersion;
+        valid = true;
+    }
+
+    // Moves to newVersion by adding and removing tags. Only the buckets that
+    // change are copied.
+    void applyDelta(juce::uint32 newVersion, const std::vector<juce::String>& added, const std::vector<juce::String>& removed)
+    {
+        std::map<int, Bucket> changed;
+
+        auto getChangedBucket = [this, &changed](const juce::String& tag) -> Bucket&
+        {
+            const auto index = getBucketIndex(tag);
+            const auto found = changed.find(index);
+
+            if (found != changed.end())
+                return found->second;
+
+            const auto& shared = buckets[static_cast<size_t>(index)];
+            return changed[index] = shared != nullptr ? *shared : Bucket();
+        };
+
+        for (const auto& tag : removed)
+        {
+            auto& bucket = getChangedBucket(tag);
+            const auto found = std::lower_bound(bucket.begin(), bucket.end(), tag);
+
+            if (found != bucket.end() && *found == tag)
+            {
+                bucket.erase(found);
+                --numTags;
+            }
+        }
+
+        for (const auto& tag : added)
+        {
+            auto& bucket = getChangedBucket(tag);
+            const auto found = std::lower_bound(bucket.begin(), bucket.end(), tag);
+
+            if (found == bucket.end() || *found != tag)
+            {
+                bucket.insert(found, tag);
+                ++numTags;
+            }
+        }
+
+        for (auto& [index, bucket] : changed)
+            buckets[static_cast<size_t>(index)] = bucket.empty() ? nullptr : std::make_shared<const Bucket>(std::move(bucket));
+
+        version = newVersion;
+    }
+
+    static int getBucketIndex(const juce::String& tag) noexcept
+    {
+        return static_cast<int>(static_cast<juce::uint64>(tag.hash()) % numBuckets);
+    }
+
+private:
+    std::array<std::shared_ptr<const Bucket>, numBuckets> buckets;
+    juce::uint32 version = 0;
+    int numTags = 0;
+    bool valid = false;
+};
+
+// Follows the catalogue protocol on the multicast receive thread:
+//
+//   /server/catalogue/snapshot ,iii s...   version, part, numParts, tags
+//   /server/catalogue/delta    ,ii  s...   version, numAdded, added tags, removed tags
+//
+// A snapshot may be split over several datagrams; it is installed once every
+// part of the same version has arrived. Delta N applies on top of version
+// N - 1. A delta that skips ahead is held back and a snapshot is asked for;
+// if the missing deltas turn up first (UDP reordering) they are applied in
+// order instead. Deltas already covered by the installed version are ignored.
+class OSCTagCatalogueSync
+{
+public:
+    static constexpr const char* snapshotAddress = "/server/catalogue/snapshot";
+    static constexpr const char* deltaAddress = "/server/catalogue/delta";
+    static constexpr const char* requestAddress = "/server/catalogue/request";
+
+    static bool isCatalogueAddress(std::string_view address) noexcept
+    {
+        return address.substr(0, 18) == "/server/catalogue/";
+    }
+
+    // Returns true if the catalogue changed
+    bool handleMessage(const OSCMessageView& message)
+    {
+        if (message.hasAddress(snapshotAddress))
+            return handleSnapshotPart(message);
+
+        if (message.hasAddress(deltaAddress))
+            return handleDelta(message);
+
+        return false;
+    }
+
+    const OSCTagCatalogue& getCatalogue() const noexcept  { return catalogue; }
+
+    // Takes over a catalogue from elsewhere (the on-disk cache). Live updates
+    // carry on from its version; if it is stale, the next delta shows the gap.
+    void adopt(const OSCTagCatalogue& other)
+    {
+        catalogue = other;
+        heldDeltas.erase(heldDeltas.begin(), heldDeltas.upper_bound(catalogue.getVersion()));
+        applyHeldDeltas();
+        snapshotWanted = !heldDeltas.empty();
+    }
+
+    // True while the catalogue is missing or behind because of a lost delta
+    bool needsSnapshot() const noexcept  { return snapshotWanted; }
+
+    // The version to put in a snapshot request: the one we have, or 0
+    juce::uint32 getRequestVersion() const noexcept  { return catalogue.isValid() ? catalogue.getVersion() : 0; }
+
+private:
+    struct Delta
+    {
+        std::vector<juce::String> added, removed;
+    };
+
+    static constexpr size_t maxHeldDeltas = 256;
+    static constexpr int maxSnapshotParts = 4096;
+
+    static bool allStrings(std::string_view typeTags) noexcept
+    {
+        return std::all_of(typeTags.begin(), typeTags.end(), [](char type) { return type == 's' || type == 'S'; });
+    }
+
+    static juce::String toString(const OSCArgument& argument)
+    {
+        return juce::String::fromUTF8(argument.getString().data(), static_cast<int>(argument.size));
+    }
+
+    bool handleSnapshotPart(const OSCMessageView& message)
+    {
+        const auto typeTags = message.getTypeTags();
+
+        if (typeTags.substr(0, 3) != "iii" || !allStrings(typeTags.substr(3)))
+            return false;
+
+        auto argument = message.begin();
+        const auto version = static_cast<juce::uint32>(argument->getInt32());
+        const auto part = (++argument)->getInt32();
+        const auto numParts = (++argument)->getInt32();
+
+        if (numParts <= 0 || numParts > maxSnapshotParts || part < 0 || part >= numParts)
+            return false;
+
+        // Servers rebroadcast snapshots; one for the version we already have
+        // is only news if we are behind. Any other version is taken, so a
+        // restarted server that counts from 1 again is followed.
+        if (catalogue.isValid() && version == catalogue.getVersion() && !snapshotWanted)
+            return false;
+
+        if (!pendingSnapshot.active || pendingSnapshot.version != version || pendingSnapshot.numParts != numParts)
+        {
+            pendingSnapshot.active = true;
+            pendingSnapshot.version = version;
+            pendingSnapshot.numParts = numParts;
+            pendingSnapshot.received.assign(static_cast<size_t>(numParts), false);
+            pendingSnapshot.tags.clear();
+            pendingSnapshot.numReceived = 0;
+        }
+
+        if (pendingSnapshot.received[static_cast<size_t>(part)])
+            return false;
+
+        pendingSnapshot.received[static_cast<size_t>(part)] = true;
+        ++pendingSnapshot.numReceived;
+
+        for (++argument; argument != message.end(); ++argument)
+            pendingSnapshot.tags.push_back(toString(*argument));
+
+        if (pendingSnapshot.numReceived < numParts)
+            return false;
+
+        OSCLog::write(OSCLog::Event::catalogueSnapshotInstalled, version, pendingSnapshot.tags.size());
+        catalogue.reset(version, pendingSnapshot.tags);
+        pendingSnapshot = {};
+
+        // Deltas held back while waiting may carry on from the snapshot
+        heldDeltas.erase(heldDeltas.begin(), heldDeltas.upper_bound(version));
+        applyHeldDeltas();
+        snapshotWanted = !heldDeltas.empty();
+        return true;
+    }
+
+    bool handleDelta(const OSCMessageView& message)
+    {
+        const auto typeTags = message.getTypeTags();
+
+        if (typeTags.substr(0, 2) != "ii" || !allStrings(typeTags.substr(2)))
+            return false;
+
+        auto argument = message.begin();
+        const auto version = static_cast<juce::uint32>(argument->getInt32());
+        const auto numAdded = (++argument)->getInt32();
+        const auto numTags = static_cast<int>(typeTags.size()) - 2;
+
+        if (numAdded < 0 || numAdded > numTags)
+            return false;
+
+        // Already covered by what we have
+        if (catalogue.isValid() && version <= catalogue.getVersion())
+            return false;
+
+        Delta delta;
+        int index = 0;
+
+        for (++argument; argument != message.end(); ++argument, ++index)
+            (index < numAdded ? delta.added : delta.removed).push_back(toString(*argument));
+
+        if (catalogue.isValid() && version == catalogue.getVersion() + 1)
+        {
+            catalogue.applyDelta(version, delta.added, delta.removed);
+            applyHeldDeltas();
+            snapshotWanted = !heldDeltas.empty();
+            return true;
+        }
+
+        // A gap, or nothing to apply it to yet
+        if (!snapshotWanted)
+            OSCLog::write(OSCLog::Event::catalogueDeltaGap, version, catalogue.getVersion());
+
+        heldDeltas[version] = std::move(delta);
+
+        if (heldDeltas.size() > maxHeldDeltas)
+            heldDeltas.erase(heldDeltas.begin());
+
+        snapshotWanted = true;
+        return false;
+    }
+
+    void applyHeldDeltas()
+    {
+        for (auto next = heldDeltas.begin(); next != heldDeltas.end() && next->first == catalogue.getVersion() + 1;)
+        {
+            catalogue.applyDelta(next->first, next->second.added, next->second.removed);
+            next = heldDeltas.erase(next);
+        }
+    }
+
+    struct PendingSnapshot
+    {
+        bool active = false;
+        juce::uint32 version = 0;
+        int numParts = 0;
+        int numReceived = 0;
+        std::vector<bool> received;
+        std::vector<juce::String> tags;
+    };
+
+    OSCTagCatalogue catalogue;
+    PendingSnapshot pendingSnapshot;
+    std::map<juce::uint32, Delta> heldDeltas;
+    bool snapshotWanted = false;
+};
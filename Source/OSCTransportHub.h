@@ -0,0 +1,398 @@
+/*
+  ==============================================================================
+
+    OSCTransportHub.h
+    Process-wide OSC transport shared by every plugin instance.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "OSC.h"
+#include "OSCEncoder.h"
+#include "OSCLog.h"
+#include "OSCMetrics.h"
+#include "OSCServerDiscovery.h"
+
+// A large session can load hundreds of instances into one process. Rather
+// than each owning sockets and a sender thread, they share this hub through
+// juce::SharedResourcePointer: it is created with the first instance and
+// destroyed with the last.
+//
+// The hub owns one I/O thread, one send socket (and bundle) per destination,
+// the multicast receiver, the directory of servers announcing on it and the
+// log writer. Instances register as clients; on every pass the thread lets
+// each client drain its own event queue into the hub, then flushes the
+// per-destination bundles, so the events that all instances produced for one
+// audio block reach a server in shared datagrams.
+class OSCTransportHub : private juce::Thread
+{
+public:
+    //==============================================================================
+    // One server address. Only used on the transport thread (or by
+    // removeClient, which excludes it).
+    class Destination
+    {
+    public:
+        Destination(const juce::String& hostToUse, int portToUse)
+            : host(hostToUse), port(portToUse)
+        {
+            // Bind to an ephemeral port so the server can reply to our sends
+            if (!socket.bindToPort(0))
+                DBG("Failed to bind OSC send socket for " << host << ":" << port << "; server replies will not be received");
+        }
+
+        const juce::String& getHost() const noexcept  { return host; }
+        int getPort() const noexcept                   { return port; }
+
+        // Sends a packet on its own, after anything already bundled for this
+        // destination so that ordering is preserved. Returns false if the
+        // socket did not take it.
+        bool send(const char* data, size_t size)
+        {
+            flush();
+            return write(data, size);
+        }
+
+        // Adds a message to the shared bundle; it goes out when the bundle is
+        // full or at the end of the current pass. If the datagram carrying
+        // it cannot be sent, failureCounter is incremented.
+        void addToBundle(const char* message, size_t size, size_t maxDatagramSize,
+                         OSCMetricCounter& failureCounter)
+        {
+            // Instances may ask for different limits; the smallest one wins
+            if (bundleBuilder.isEmpty() || maxDatagramSize < bundleBuilder.getMaxDatagramSize())
+                bundleBuilder.setMaxDatagramSize(maxDatagramSize);
+
+            bundleBuilder.addMessage(message, size, [this, message, &failureCounter](const char* data, size_t dataSize)
+            {
+                // Too big to bundle, so it went out on its own
+                if (data == message)
+                {
+                    if (!write(data, dataSize))
+                        failureCounter.add();
+
+                    return;
+                }
+
+                writeBundle(data, dataSize);
+            });
+
+            if (!bundleBuilder.isEmpty()
+                && std::find(bundleFailureCounters.begin(), bundleFailureCounters.end(), &failureCounter) == bundleFailureCounters.end())
+                bundleFailureCounters.push_back(&failureCounter);
+        }
+
+        void flush()
+        {
+            bundleBuilder.flush([this](const char* data, size_t dataSize) { writeBundle(data, dataSize); });
+        }
+
+    private:
+        friend class OSCTransportHub;
+
+        bool write(const char* data, size_t size)
+        {
+            const auto packetSize = static_cast<int>(size);
+
+            if (socket.write(host, port, data, packetSize) == packetSize)
+            {
+                OSCLog::write(OSCLog::Event::packetSent, packetSize, port);
+                return true;
+            }
+
+            // Counted by the caller; a full socket buffer or an unreachable
+            // server is not a programming error
+            OSCLog::write(OSCLog::Event::sendFailed, packetSize, port);
+            return false;
+        }
+
+        // A bundle that cannot be sent counts against every instance with a
+        // message in it
+        void writeBundle(const char* data, size_t size)
+        {
+            if (!write(data, size))
+                for (auto* counter : bundleFailureCounters)
+                    counter->add();
+
+            bundleFailureCounters.clear();
+        }
+
+        juce::String host;
+        int port;
+        juce::DatagramSocket socket;
+        juce::HeapBlock<char> bundleBuffer { OSCEventEncoder::maxPacketSize };
+        OSCBundleBuilder bundleBuilder { bundleBuffer.getData(), OSCEventEncoder::maxPacketSize };
+        std::vector<OSCMetricCounter*> bundleFailureCounters;
+
+        JUCE_DECLARE_NON_COPYABLE(Destination)
+    };
+
+    //==============================================================================
+    // Implemented by each plugin instance. Both callbacks run on the transport
+    // thread, never concurrently with each other or with another client.
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+
+        // Drain queued events into the hub and do any periodic work. Returns
+        // the number of events handled.
+        virtual int serviceTransport(OSCTransportHub& hub, double nowMs) = 0;
+
+        // A datagram arrived on a destination's socket. Every client gets
+        // every reply and picks out the ones meant for it.
+        virtual void handleServerReply(const Destination& source, const char* data, int size, double nowMs) = 0;
+
+        // Whether this client picks its server from the directory. Servers
+        // are only pinged while at least one client does.
+        virtual bool usesAutoConnect() = 0;
+    };
+
+    //==============================================================================
+    OSCTransportHub()
+        : juce::Thread("OSC Transport"),
+          receiver(OSCServerDirectory::multicastGroup, OSCServerDirectory::multicastPort)
+    {
+        receiver.getDispatcher().addHandler(OSCServerDirectory::announceAddress, [this](const OSCMessageView& message, juce::uint64)
+        {
+            serverDirectory.handleAnnouncement(message, receiver.getCurrentSenderAddress(), juce::Time::getMillisecondCounterHiRes());
+        });
+
+        if (!pingSocket.bindToPort(0))
+            DBG("Failed to bind the server ping socket; servers will not be ranked by round trip");
+
+        startThread(juce::Thread::Priority::high);
+    }
+
+    ~OSCTransportHub() override
+    {
+        stopThread(1000);
+
+        // All clients have gone by the time the last SharedResourcePointer dies
+        jassert(clients.empty() && newClients.empty() && removedClients.empty());
+    }
+
+    // Message thread. Neither call holds a lock across the transport
+    // thread's I/O. addClient never waits: new clients are picked up at the
+    // start of the next pass, and their events wait in their own queues
+    // until then. removeClient queues the client for removal and waits until
+    // the transport thread has drained it one last time and let go of it,
+    // at most the rest of the current pass, so the client can be destroyed
+    // as soon as it returns.
+    void addClient(Client& client)
+    {
+        {
+            const juce::SpinLock::ScopedLockType sl(clientChangeLock);
+            newClients.push_back(&client);
+        }
+
+        notify();
+    }
+
+    void removeClient(Client& client)
+    {
+        juce::uint64 ticket;
+
+        {
+            const juce::SpinLock::ScopedLockType sl(clientChangeLock);
+            removedClients.push_back(&client);
+            ticket = ++numRemovalsRequested;
+        }
+
+        // Cut the thread's idle wait short
+        notify();
+
+        while (numRemovalsHandled.load(std::memory_order_acquire) < ticket)
+            removalHandled.wait(5);
+    }
+
+    // Transport thread only: the shared socket and bundle for a server,
+    // created on first use and kept for the lifetime of the hub
+    Destination& getDestination(const juce::String& host, int port)
+    {
+        for (auto& destination : destinations)
+            if (destination->port == port && destination->host == host)
+                return *destination;
+
+        destinations.push_back(std::make_unique<Destination>(host, port));
+        return *destinations.back();
+    }
+
+    // Transport thread only: scratch space for encoding one packet
+    OSCPacketWriter createPacketWriter() noexcept
+    {
+        return OSCPacketWriter(packetBuffer.getData(), OSCEventEncoder::maxPacketSize);
+    }
+
+    // Shared by all instances; used from the message thread only
+    OSCMulticastReceiver& getMulticastReceiver() noexcept  { return receiver; }
+
+    // Servers heard on the multicast group; any thread but the audio thread
+    OSCServerDirectory& getServerDirectory() noexcept  { return serverDirectory; }
+
+private:
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            int numEvents = 0;
+
+            const auto nowMs = juce::Time::getMillisecondCounterHiRes();
+
+            applyClientChanges(nowMs);
+            readReplies(nowMs);
+
+            bool anyAutoConnect = false;
+
+            for (auto* client : clients)
+                anyAutoConnect = anyAutoConnect || client->usesAutoConnect();
+
+            // On a socket of their own, so that a ping never flushes or
+            // overtakes the bundle pending for a server that is also a
+            // destination
+            serverDirectory.servicePings(nowMs, anyAutoConnect, [this](const juce::String& host, int port, const char* data, size_t size)
+            {
+                pingSocket.write(host, port, data, static_cast<int>(size));
+            });
+
+            for (auto* client : clients)
+                numEvents += client->serviceTransport(*this, nowMs);
+
+            flushAll();
+
+            // The audio threads never signal us, because waking a thread means
+            // taking a lock, so the queues are polled: every millisecond while
+            // events are flowing, backing off to maxIdleWaitMs once they have
+            // stopped, so that an idle process is not woken a thousand times a
+            // second
+            if (numEvents > 0)
+            {
+                lastEventMs = nowMs;
+                idleWaitMs = 1;
+            }
+            else
+            {
+                if (nowMs - lastEventMs > busyHoldMs)
+                    idleWaitMs = juce::jmin(idleWaitMs * 2, maxIdleWaitMs);
+
+                wait(idleWaitMs);
+            }
+        }
+
+        // Release any removeClient that came in during the last pass
+        applyClientChanges(juce::Time::getMillisecondCounterHiRes());
+        OSCLog::releaseThread();
+    }
+
+    // Takes the clients added and removed since the last pass. Only the list
+    // swap happens under the lock; removed clients are drained after it, and
+    // then removeClient is released.
+    void applyClientChanges(double nowMs)
+    {
+        juce::uint64 ticket;
+
+        {
+            const juce::SpinLock::ScopedLockType sl(clientChangeLock);
+            clients.insert(clients.end(), newClients.begin(), newClients.end());
+            newClients.clear();
+            removingClients.swap(removedClients);
+            ticket = numRemovalsRequested;
+        }
+
+        if (removingClients.empty())
+            return;
+
+        for (auto* client : removingClients)
+        {
+            clients.erase(std::remove(clients.begin(), clients.end(), client), clients.end());
+
+            // Send whatever it queued before it went
+            client->serviceTransport(*this, nowMs);
+        }
+
+        flushAll();
+        removingClients.clear();
+
+        numRemovalsHandled.store(ticket, std::memory_order_release);
+        removalHandled.signal();
+    }
+
+    void readReplies(double nowMs)
+    {
+        for (;;)
+        {
+            const auto bytesRead = pingSocket.read(replyBuffer.getData(), replyBufferSize, false);
+
+            if (bytesRead <= 0)
+                break;
+
+            OSCMessageView message;
+
+            if (message.parse(replyBuffer.getData(), static_cast<size_t>(bytesRead)))
+                serverDirectory.handlePong(message, nowMs);
+        }
+
+        for (auto& destination : destinations)
+        {
+            for (;;)
+            {
+                const auto bytesRead = destination->socket.read(replyBuffer.getData(), replyBufferSize, false);
+
+                if (bytesRead <= 0)
+                    break;
+
+                for (auto* client : clients)
+                    client->handleServerReply(*destination, replyBuffer.getData(), bytesRead, nowMs);
+            }
+        }
+    }
+
+    void flushAll()
+    {
+        for (auto& destination : destinations)
+            destination->flush();
+    }
+
+    // Replies can be bundles of MIDI, so take anything a datagram can hold
+    static constexpr int replyBufferSize = static_cast<int>(OSCEventEncoder::maxPacketSize);
+
+    // Polling stays at 1 ms for this long after the last event, which covers
+    // the gaps between notes while a host is playing. After that the first
+    // event can wait up to maxIdleWaitMs.
+    static constexpr double busyHoldMs = 500.0;
+    static constexpr int maxIdleWaitMs = 10;
+
+    // First, so that it outlives everything that logs
+    OSCLogWriter logWriter;
+
+    // Transport thread only
+    std::vector<Client*> clients;
+    std::vector<Client*> removingClients;
+    double lastEventMs = 0.0;
+    int idleWaitMs = 1;
+
+    // Handed over from the message thread
+    juce::SpinLock clientChangeLock;
+    std::vector<Client*> newClients;
+    std::vector<Client*> removedClients;
+    juce::uint64 numRemovalsRequested = 0;
+    std::atomic<juce::uint64> numRemovalsHandled { 0 };
+    juce::WaitableEvent removalHandled;
+    std::vector<std::unique_ptr<Destination>> destinations;
+
+    juce::HeapBlock<char> packetBuffer { OSCEventEncoder::maxPacketSize };
+    juce::HeapBlock<char> replyBuffer { replyBufferSize };
+    juce::DatagramSocket pingSocket;
+
+    OSCServerDirectory serverDirectory;
+    OSCMulticastReceiver receiver;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OSCTransportHub)
+};
@@ -14,7 +14,7 @@ OSC_ClientAudioProcessorEditor::OSC_ClientAudioProcessorEditor(OSC_ClientAudioPr
 	: AudioProcessorEditor(&p), audioProcessor(p)
 {
 	setLookAndFeel(&globalLookAndFeel);
-	setSize(480, 320);
+	setSize(480, 356);
 
 	const juce::Font headingFont(juce::FontOptions("Segoe UI", 16.0f, juce::Font::bold));
 	const juce::Font labelFont(juce::FontOptions("Segoe UI", 13.0f, juce::Font::bold));
@@ -67,6 +67,28 @@ OSC_ClientAudioProcessorEditor::OSC_ClientAudioProcessorEditor(OSC_ClientAudioPr
 	portEditor.setJustification(juce::Justification::centredLeft);
 	portEditor.setText(juce::String(audioProcessor.getPort()));
 
+	addAndMakeVisible(serverNameLabel);
+	serverNameLabel.setText("Server", juce::dontSendNotification);
+	serverNameLabel.setColour(juce::Label::textColourId, juce::Colours::whitesmoke);
+	serverNameLabel.setFont(labelFont);
+
+	addAndMakeVisible(serverNameEditor);
+	serverNameEditor.setMultiLine(false);
+	serverNameEditor.setReturnKeyStartsNewLine(false);
+	serverNameEditor.setReadOnly(false);
+	serverNameEditor.setScrollbarsShown(false);
+	serverNameEditor.addListener(this);
+	serverNameEditor.setFont(editorFont);
+	serverNameEditor.setJustification(juce::Justification::centredLeft);
+	serverNameEditor.setTextToShowWhenEmpty("Nearest", juce::Colours::white.withAlpha(0.4f));
+	serverNameEditor.setText(audioProcessor.getServerName());
+
+	addAndMakeVisible(autoConnectToggle);
+	autoConnectToggle.setButtonText("Auto");
+	autoConnectToggle.setToggleState(audioProcessor.getAutoConnect(), juce::dontSendNotification);
+	autoConnectToggle.onClick = [this]()
+	{ audioProcessor.setAutoConnect(autoConnectToggle.getToggleState()); };
+
 	addAndMakeVisible(reconnectButton);
 	reconnectButton.setButtonText("Reconnect");
 	reconnectButton.setColour(juce::TextButton::buttonColourId, globalLookAndFeel.getPanelColour().brighter(0.1f));
@@ -78,7 +100,7 @@ OSC_ClientAudioProcessorEditor::OSC_ClientAudioProcessorEditor(OSC_ClientAudioPr
 	getTagsButton.setColour(juce::TextButton::buttonColourId, globalLookAndFeel.getAccentColour());
 	getTagsButton.onClick = [this]()
 	{
-		auto tags = audioProcessor.receiver.getLatestTags();
+		auto tags = audioProcessor.getMulticastReceiver().getLatestTags();
 		// convert StringArray to new line separated string list
 		juce::String tagsAsString = tags.joinIntoString("\n");
 
@@ -86,12 +108,44 @@ OSC_ClientAudioProcessorEditor::OSC_ClientAudioProcessorEditor(OSC_ClientAudioPr
 		audioProcessor.setTags(tagsAsString);
 	};
 
+	addAndMakeVisible(bundleToggle);
+	bundleToggle.setButtonText("Bundle");
+	bundleToggle.setToggleState(audioProcessor.getBundleEvents(), juce::dontSendNotification);
+	bundleToggle.onClick = [this]()
+	{ audioProcessor.setBundleEvents(bundleToggle.getToggleState()); };
+
+	addAndMakeVisible(compactTagsToggle);
+	compactTagsToggle.setButtonText("Compact tags");
+	compactTagsToggle.setToggleState(audioProcessor.getCompactTags(), juce::dontSendNotification);
+	compactTagsToggle.onClick = [this]()
+	{ audioProcessor.setCompactTags(compactTagsToggle.getToggleState()); };
+
+	addAndMakeVisible(rawMidiToggle);
+	rawMidiToggle.setButtonText("Raw MIDI");
+	rawMidiToggle.setToggleState(audioProcessor.getWireFormat() == OSCWireFormat::midi, juce::dontSendNotification);
+	rawMidiToggle.onClick = [this]()
+	{ audioProcessor.setWireFormat(rawMidiToggle.getToggleState() ? OSCWireFormat::midi : OSCWireFormat::strings); };
+
+	addAndMakeVisible(receiveMidiToggle);
+	receiveMidiToggle.setButtonText("MIDI in");
+	receiveMidiToggle.setToggleState(audioProcessor.getReceiveMidi(), juce::dontSendNotification);
+	receiveMidiToggle.onClick = [this]()
+	{ audioProcessor.setReceiveMidi(receiveMidiToggle.getToggleState()); };
+
 	addAndMakeVisible(aboutButton);
 	aboutButton.setButtonText("About");
 	aboutButton.onClick = [this]()
 	{
 		showAboutDialog();
 	};
+
+	addAndMakeVisible(metricsLabel);
+	metricsLabel.setFont(juce::Font(juce::FontOptions("Segoe UI", 12.0f, juce::Font::plain)));
+	metricsLabel.setColour(juce::Label::textColourId, juce::Colours::whitesmoke.withAlpha(0.7f));
+	metricsLabel.setJustificationType(juce::Justification::centredLeft);
+
+	timerCallback();
+	startTimerHz(4);
 }
 
 void OSC_ClientAudioProcessorEditor::textEditorFocusLost(juce::TextEditor &lostEditor)
@@ -110,6 +164,10 @@ void OSC_ClientAudioProcessorEditor::textEditorFocusLost(juce::TextEditor &lostE
 		// Send the text to the processor
 		audioProcessor.setPort(text.getIntValue());
 	}
+	else if (&lostEditor == &serverNameEditor)
+	{
+		audioProcessor.setServerName(serverNameEditor.getText());
+	}
 	else if (&lostEditor == &this->textEditor)
 	{
 		// Get the text from the text editor
@@ -121,9 +179,32 @@ void OSC_ClientAudioProcessorEditor::textEditorFocusLost(juce::TextEditor &lostE
 
 OSC_ClientAudioProcessorEditor::~OSC_ClientAudioProcessorEditor()
 {
+	stopTimer();
 	setLookAndFeel(nullptr);
 }
 
+void OSC_ClientAudioProcessorEditor::timerCallback()
+{
+	const auto metrics = audioProcessor.getMetrics();
+
+	auto formatMicros = [](juce::uint32 micros)
+	{
+		return micros >= 1000 ? juce::String(micros / 1000.0, 1) + " ms" : juce::String(micros) + " us";
+	};
+
+	const auto text = "In " + juce::String(metrics.eventsIn)
+		+ "   Out " + juce::String(metrics.messagesOut) + " (" + juce::File::descriptionOfSizeInBytes((juce::int64) metrics.bytesOut) + ")"
+		+ "   Coalesced " + juce::String(metrics.eventsCoalesced)
+		+ "   Overflows " + juce::String(metrics.queueOverflows + metrics.eventsTruncated)
+		+ "   Send errors " + juce::String(metrics.sendFailures + metrics.encodeFailures)
+		+ "\nReceived " + juce::String(metrics.datagramsReceived)
+		+ "   Parse errors " + juce::String(metrics.parseErrors)
+		+ "   Queue p99 " + formatMicros(metrics.queueLatencyMicros.getPercentile(99.0))
+		+ "   Block p99 " + formatMicros(metrics.processBlockMicros.getPercentile(99.0));
+
+	metricsLabel.setText(text, juce::dontSendNotification);
+}
+
 //==============================================================================
 void OSC_ClientAudioProcessorEditor::paint(juce::Graphics &g)
 {
@@ -149,22 +230,34 @@ void OSC_ClientAudioProcessorEditor::resized()
 	auto bounds = getLocalBounds().reduced(24);
 
 	auto buttonRow = bounds.removeFromBottom(40);
-	bounds.removeFromBottom(16);
+	bounds.removeFromBottom(8);
+
+	metricsLabel.setBounds(bounds.removeFromBottom(32));
+	bounds.removeFromBottom(8);
 
 	auto connectionArea = bounds.removeFromBottom(74);
 	bounds.removeFromBottom(12);
 
 	auto headerArea = bounds.removeFromTop(30);
-	label.setBounds(headerArea.removeFromLeft(180));
+	label.setBounds(headerArea.removeFromLeft(44));
+	bundleToggle.setBounds(headerArea.removeFromRight(80));
+	headerArea.removeFromRight(8);
+	compactTagsToggle.setBounds(headerArea.removeFromRight(105));
+	headerArea.removeFromRight(8);
+	rawMidiToggle.setBounds(headerArea.removeFromRight(90));
+	headerArea.removeFromRight(8);
+	receiveMidiToggle.setBounds(headerArea.removeFromRight(80));
 
 	bounds.removeFromTop(8);
 	auto tagsArea = bounds;
 	textEditor.setBounds(tagsArea);
 
-	auto columnWidth = (connectionArea.getWidth() - 16) / 2;
+	auto columnWidth = (connectionArea.getWidth() - 32) / 3;
 	auto ipColumn = connectionArea.removeFromLeft(columnWidth);
 	connectionArea.removeFromLeft(16);
-	auto portColumn = connectionArea;
+	auto portColumn = connectionArea.removeFromLeft(columnWidth);
+	connectionArea.removeFromLeft(16);
+	auto serverColumn = connectionArea;
 
 	auto labelHeight = 20;
 	auto editorHeight = 32;
@@ -177,6 +270,12 @@ void OSC_ClientAudioProcessorEditor::resized()
 	portColumn.removeFromTop(4);
 	portEditor.setBounds(portColumn.removeFromTop(editorHeight));
 
+	auto serverLabelRow = serverColumn.removeFromTop(labelHeight);
+	autoConnectToggle.setBounds(serverLabelRow.removeFromRight(64));
+	serverNameLabel.setBounds(serverLabelRow);
+	serverColumn.removeFromTop(4);
+	serverNameEditor.setBounds(serverColumn.removeFromTop(editorHeight));
+
 	auto buttonWidth = (buttonRow.getWidth() - 32) / 3;
 
 	reconnectButton.setBounds(buttonRow.removeFromLeft(buttonWidth));
@@ -137,7 +137,8 @@ private:
     const juce::Colour shadowColour;
 };
 
-class OSC_ClientAudioProcessorEditor : public juce::AudioProcessorEditor, public juce::TextEditor::Listener
+class OSC_ClientAudioProcessorEditor : public juce::AudioProcessorEditor, public juce::TextEditor::Listener,
+                                       private juce::Timer
 {
 public:
 	// Add the listener to the class
@@ -167,6 +168,11 @@ private:
 	juce::Label portLabel;
 	juce::TextEditor portEditor;
 
+	// Server auto-discovery: a server name (blank for the nearest) and a toggle
+	juce::Label serverNameLabel;
+	juce::TextEditor serverNameEditor;
+	juce::ToggleButton autoConnectToggle;
+
 	// Create a button for IP and port reconnection
 	juce::TextButton reconnectButton;
 
@@ -176,9 +182,25 @@ private:
     // About button
     juce::TextButton aboutButton;
 
+	// Toggle sending one OSC bundle per processBlock
+	juce::ToggleButton bundleToggle;
+
+	// Toggle registering tags with the server for a compact handle
+	juce::ToggleButton compactTagsToggle;
+
+	// Toggle sending raw MIDI bytes as an OSC 'm' argument
+	juce::ToggleButton rawMidiToggle;
+
+	// Toggle playing MIDI sent back by the server
+	juce::ToggleButton receiveMidiToggle;
+
+	// Send and receive counters, refreshed from the processor's metrics
+	juce::Label metricsLabel;
+
 	GlobalLookAndFeel globalLookAndFeel;
 
     void showAboutDialog();
+    void timerCallback() override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OSC_ClientAudioProcessorEditor)
 };
@@ -9,47 +9,7 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
-namespace
-{
-    juce::String describeOscArgument(const juce::OSCArgument& argument)
-    {
-        if (argument.isInt32())
-            return "int32:" + juce::String(argument.getInt32());
-
-        if (argument.isFloat32())
-            return "float:" + juce::String(argument.getFloat32());
-
-        if (argument.isString())
-            return "string=\"" + argument.getString() + "\"";
-
-        if (argument.isBlob())
-            return "blob(" + juce::String(argument.getBlob().getSize()) + " bytes)";
-
-        if (argument.isColour())
-        {
-            const auto c = argument.getColour();
-            return "colour:rgba("
-                + juce::String(static_cast<int>(c.red)) + ","
-                + juce::String(static_cast<int>(c.green)) + ","
-                + juce::String(static_cast<int>(c.blue)) + ","
-                + juce::String(static_cast<int>(c.alpha)) + ")";
-        }
-
-        const char typeChars[2] = { argument.getType(), 0 };
-        return "type(" + juce::String::fromUTF8(typeChars) + ")";
-    }
-
-    juce::String describeOscMessage(const juce::OSCMessage& message)
-    {
-        juce::StringArray argumentDescriptions;
-
-        for (int i = 0; i < message.size(); ++i)
-            argumentDescriptions.add(describeOscArgument(message[i]));
-
-        return "address=" + message.getAddressPattern().toString()
-            + ", args=[" + argumentDescriptions.joinIntoString(", ") + "]";
-    }
-}
+static std::atomic<juce::int32> nextInstanceId { 0 };
 
 //==============================================================================
 OSC_ClientAudioProcessor::OSC_ClientAudioProcessor()
@@ -62,26 +22,50 @@ OSC_ClientAudioProcessor::OSC_ClientAudioProcessor()
         .withOutput("Output", juce::AudioChannelSet::stereo(), true)
 #endif
         
-    ), receiver("239.255.0.1", 9000)
+    ),
+#else
+    :
 #endif
+       instanceId(++nextInstanceId)
 {
-    DBG("OSC Client Plugin Constructor");
+    wallClockOffsetMs = static_cast<double>(juce::Time::currentTimeMillis()) - juce::Time::getMillisecondCounterHiRes();
 
-    bool success = oscSender.connect("127.0.0.1", 8000);
-    if (success)
+    // Messages the server sends back to this instance
+    replyDispatcher.addHandler("/client/tags_ack", [this](const OSCMessageView& message, juce::uint64)
     {
-        DBG("Connected to OSC server");
-    }
-    else
+        handleTagAcknowledgement(message);
+    });
+
+    replyDispatcher.addHandler("/midi/{raw,raw_id}", [this](const OSCMessageView& message, juce::uint64)
     {
-        DBG("Failed to connect to OSC server");
-    }
+        handleIncomingMidi(message);
+    });
+
+    replyDispatcher.addHandler("/client/stats", [this](const OSCMessageView& message, juce::uint64)
+    {
+        handleStatsRequest(message);
+    });
 
+    // "/client/log_level ,i level" with 0 (trace) to 5 (off). The level is
+    // shared by every instance in the process.
+    replyDispatcher.addHandler("/client/log_level", [](const OSCMessageView& message, juce::uint64)
+    {
+        if (message.hasTypeTags("i"))
+            OSCLog::setLevel(static_cast<OSCLog::Level>(juce::jlimit(0, static_cast<int>(OSCLog::Level::off), message.begin()->getInt32())));
+    });
+
+    if (juce::SystemStats::getEnvironmentVariable("OSC_CLIENT_LATENCY_PROBES", {}) == "1")
+        setLatencyProbes(true);
+
+    transportHub->addClient(*this);
 }
 
 
 OSC_ClientAudioProcessor::~OSC_ClientAudioProcessor()
 {
+    // The transport thread calls back into this object, so leave the hub
+    // (sending whatever is still queued) before any member it touches is destroyed
+    transportHub->removeClient(*this);
 }
 
 //==============================================================================
@@ -156,6 +140,14 @@ void OSC_ClientAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBl
     // initialisation that you need..
     DBG("prepareToPlay called with sampleRate: " << sampleRate << ", samplesPerBlock: " << samplesPerBlock);
 
+    currentSampleRate = sampleRate > 0 ? sampleRate : 44100.0;
+
+    // Map the monotonic high-resolution counter onto wall-clock time so that
+    // block start times can be expressed as absolute NTP time tags
+    wallClockOffsetMs = static_cast<double>(juce::Time::currentTimeMillis()) - juce::Time::getMillisecondCounterHiRes();
+    blockClockAnchored = false;
+    controllerCoalescer.reset();
+    numPendingIncomingMidi = 0;
 }
 
 void OSC_ClientAudioProcessor::releaseResources()
@@ -190,113 +182,718 @@ bool OSC_ClientAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts
 }
 #endif
 
+double OSC_ClientAudioProcessor::advanceBlockClock(int numSamples)
+{
+    // Block start times advance by exactly one block's worth of samples, so
+    // the jitter in when the host happens to call processBlock does not leak
+    // into the time tags. If the sample clock drifts too far from the wall
+    // clock (transport jumps, offline bounces, device restarts) re-anchor it.
+    const auto nowMs = juce::Time::getMillisecondCounterHiRes() + wallClockOffsetMs;
+    const auto blockDurationMs = 1000.0 * numSamples / currentSampleRate;
+    const auto expectedMs = blockClockAnchorMs + 1000.0 * static_cast<double>(samplesSinceAnchor) / currentSampleRate;
+    const auto maxDeviationMs = juce::jmax(50.0, 4.0 * blockDurationMs);
+
+    if (!blockClockAnchored || std::abs(nowMs - expectedMs) > maxDeviationMs)
+    {
+        blockClockAnchorMs = nowMs;
+        samplesSinceAnchor = 0;
+        blockClockAnchored = true;
+    }
+
+    const auto blockStartSeconds = (blockClockAnchorMs + 1000.0 * static_cast<double>(samplesSinceAnchor) / currentSampleRate) / 1000.0;
+    samplesSinceAnchor += numSamples;
+    return blockStartSeconds;
+}
+
 void OSC_ClientAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-    juce::ignoreUnused(buffer);
-    juce::MidiMessage message;
+    // Runs on the real-time thread: only copy the raw bytes into the queue.
+    // Encoding and socket I/O happen on the shared transport thread.
+    const RealtimeChecker::ScopedSection realtimeSection;
+    const auto entryMicros = OSCLatencyProbe::nowMicros();
+    const auto blockIndex = ++blockCounter;
+    const auto blockStartSeconds = advanceBlockClock(buffer.getNumSamples());
+    int numBlockEvents = 0;
+    int numTruncated = 0;
 
     for (const auto meta : midiMessages)
     {
-        message = meta.getMessage();
+        if (meta.numBytes < 3)
+            continue;
+
+        OSCEvent event;
+        event.status = meta.data[0];
+        event.data1 = meta.data[1];
+        event.data2 = meta.data[2];
+
+        // Only what is sent counts towards the limit: pitch bend, aftertouch
+        // and the like are never truncated because they are never sent
+        if (!event.isNoteOn() && !event.isNoteOff() && !event.isController())
+            continue;
+
+        if (numBlockEvents == maxEventsPerBlock)
+        {
+            ++numTruncated;
+            continue;
+        }
+
+        event.samplePosition = meta.samplePosition;
+        event.blockIndex = blockIndex;
+        event.entryMicros = entryMicros;
+        event.timeTag = OSCEventEncoder::toTimeTag(blockStartSeconds + meta.samplePosition / currentSampleRate);
+        stagedEvents[numBlockEvents++] = event;
+    }
+
+    metrics.eventsIn.add(static_cast<juce::uint64>(numBlockEvents));
+
+    // Held-back controller values released into this block can crowd out
+    // the last of its own events, so the coalescer can truncate too
+    const OSCConfigPublisher::ScopedRead config(configPublisher, OSCClientConfig::audioThreadReader);
+    int numCoalescerTruncated = 0;
+    numBlockEvents = controllerCoalescer.process(stagedEvents.getData(), numBlockEvents,
+                                                 blockEvents.getData(), maxEventsPerBlock,
+                                                 config->controllerFilter, blockStartSeconds,
+                                                 currentSampleRate, blockIndex, numCoalescerTruncated);
+    numTruncated += numCoalescerTruncated;
+
+    if (numTruncated > 0)
+    {
+        metrics.eventsTruncated.add(static_cast<juce::uint64>(numTruncated));
+        OSCLog::write(OSCLog::Event::blockTruncated, numTruncated, blockIndex, maxEventsPerBlock);
+    }
+
+    if (!eventQueue.push(blockEvents.getData(), numBlockEvents))
+        OSCLog::write(OSCLog::Event::queueOverflow, numBlockEvents, blockIndex);
+
+    // Only after the input has been queued, so nothing from the server is echoed back
+    renderIncomingMidi(midiMessages, buffer.getNumSamples(), blockStartSeconds, config->receiveMidi);
+
+    metrics.processBlockMicros.record(OSCLatencyProbe::nowMicros() - entryMicros);
+}
+
+void OSC_ClientAudioProcessor::renderIncomingMidi(juce::MidiBuffer& midiMessages, int numSamples, double blockStartSeconds, bool enabled)
+{
+    incomingMidiQueue.popAll([this](const OSCEvent& event)
+    {
+        if (numPendingIncomingMidi < maxPendingIncomingMidi)
+            pendingIncomingMidi[numPendingIncomingMidi++] = event;
+        else
+        {
+            numIncomingMidiDropped.fetch_add(1, std::memory_order_relaxed);
+            OSCLog::write(OSCLog::Event::incomingMidiDropped);
+        }
+    });
+
+    if (!enabled)
+    {
+        numPendingIncomingMidi = 0;
+        return;
+    }
+
+    int numKept = 0;
+
+    for (int i = 0; i < numPendingIncomingMidi; ++i)
+    {
+        const auto& event = pendingIncomingMidi[i];
+        int samplePosition = 0;
+        double lateMs = 0.0;
+
+        if (event.timeTag != OSCEventEncoder::immediateTimeTag)
+        {
+            const auto offsetSeconds = OSCEventEncoder::toSecondsSinceUnixEpoch(event.timeTag) - blockStartSeconds;
+            const auto offsetSamples = std::floor(offsetSeconds * currentSampleRate);
+
+            // Events for a later block wait for it
+            if (offsetSamples >= numSamples)
+            {
+                pendingIncomingMidi[numKept++] = event;
+                continue;
+            }
+
+            // Events whose time has already passed go out at the start of the block
+            if (offsetSamples < 0)
+                lateMs = -offsetSeconds * 1000.0;
+            else
+                samplePosition = static_cast<int>(offsetSamples);
+        }
 
-        DBG("Received MIDI message: " << message.getDescription()); // Add this line
+        const juce::uint8 bytes[] = { event.status, event.data1, event.data2 };
+        const auto numBytes = juce::MidiMessage::getMessageLengthFromFirstByte(event.status);
 
+        // Growing the host's buffer would allocate; what does not fit waits
+        // for the next block
+        if (!canAddWithoutAllocating(midiMessages, numBytes))
+        {
+            numIncomingMidiHeldForCapacity.fetch_add(1, std::memory_order_relaxed);
+            pendingIncomingMidi[numKept++] = event;
+            continue;
+        }
 
-        if (message.isNoteOnOrOff() || message.isController())
+        // Counted once, when the event is actually rendered
+        if (lateMs > 0.0)
         {
-            sendOscMessage(message);
+            numIncomingMidiLate.fetch_add(1, std::memory_order_relaxed);
+
+            if (lateMs > maxIncomingMidiLateMs.load(std::memory_order_relaxed))
+                maxIncomingMidiLateMs.store(lateMs, std::memory_order_relaxed);
         }
+
+        midiMessages.addEvent(bytes, numBytes, samplePosition);
     }
+
+    numPendingIncomingMidi = numKept;
+}
+
+bool OSC_ClientAudioProcessor::canAddWithoutAllocating(const juce::MidiBuffer& buffer, int numBytes)
+{
+    // Each MidiBuffer event is stored as an int32 sample position, a uint16
+    // size and the bytes themselves
+    const auto eventSize = static_cast<int>(sizeof(juce::int32) + sizeof(juce::uint16)) + numBytes;
+    return buffer.data.size() + eventSize <= buffer.data.getNumAllocated();
+}
+
+template <typename Modifier>
+void OSC_ClientAudioProcessor::updateSettings(Modifier&& modify)
+{
+    const juce::ScopedLock sl(settingsLock);
+    modify(settings);
+    configPublisher.publish(settings);
 }
 
 void OSC_ClientAudioProcessor::setTags(const juce::String& tagsString)
 {
     // split by newline
-	tags = juce::StringArray::fromLines(tagsString);
+	const auto newTags = juce::StringArray::fromLines(tagsString);
+	auto newSuffix = OSCTagSuffix::fromTags(newTags);
+
+	updateSettings([&](OSCClientConfig& config)
+	{
+		config.tags = newTags;
+		config.tagSuffix = std::move(newSuffix);
+	});
+
 	DBG("Tags set to: " << tagsString);
 
 }
 
 juce::String OSC_ClientAudioProcessor::getTags()
 {
-    juce::String tagsText = tags.joinIntoString("\n");
+    const juce::ScopedLock sl(settingsLock);
+    return settings.tags.joinIntoString("\n");
+}
 
-	DBG("Tags set to: " << tagsText);
-	return tagsText;
+int OSC_ClientAudioProcessor::serviceTransport(OSCTransportHub& hub, double nowMs)
+{
+    const auto numEvents = eventQueue.popAll([this, &hub](const OSCEvent& event) { sendOscMessage(hub, event); });
+    serviceTagRegistration(hub, nowMs);
+    return numEvents;
 }
 
-void OSC_ClientAudioProcessor::sendOscMessage(const juce::MidiMessage& message)
+bool OSC_ClientAudioProcessor::usesAutoConnect()
 {
-    juce::OSCMessage oscMessage = createOscMessage(message);
+    const OSCConfigPublisher::ScopedRead config(configPublisher, OSCClientConfig::transportThreadReader);
+    return config->autoConnect;
+}
 
-    if (tags.isEmpty())
+OSCTransportHub::Destination& OSC_ClientAudioProcessor::getDestination(OSCTransportHub& hub, const OSCConfigPublisher::ScopedRead& config)
+{
+    auto& directory = hub.getServerDirectory();
+    const auto directoryGeneration = directory.getGeneration();
+
+    if (destination == nullptr || destinationConfigVersion != config.getVersion()
+        || (config->autoConnect && destinationDirectoryGeneration != directoryGeneration))
     {
-        DBG("Skipping OSC send: no tags configured to target an instrument.");
+        OSCServerDirectory::Endpoint current, selected;
+
+        if (destination != nullptr)
+            current = { destination->getHost(), destination->getPort() };
+
+        // Fall back to the configured address while no suitable server is announcing
+        if (config->autoConnect && directory.select(config->serverName, destination != nullptr ? &current : nullptr, selected))
+            destination = &hub.getDestination(selected.host, selected.port);
+        else
+            destination = &hub.getDestination(config->ipAddress, config->port);
+
+        if (destination != activeDestination.load())
+            DBG("Sending OSC to " << destination->getHost() << ":" << destination->getPort());
+
+        destinationConfigVersion = config.getVersion();
+        destinationDirectoryGeneration = directoryGeneration;
+        activeDestination.store(destination);
+    }
+
+    return *destination;
+}
+
+void OSC_ClientAudioProcessor::sendOscMessage(OSCTransportHub& hub, const OSCEvent& event)
+{
+    const OSCConfigPublisher::ScopedRead config(configPublisher, OSCClientConfig::transportThreadReader);
+
+    if (config->tags.isEmpty())
+    {
+        OSCLog::write(OSCLog::Event::eventSkippedNoTags);
         return;
     }
 
-    for (const auto& tag : tags)
+    auto writer = hub.createPacketWriter();
+    auto& target = getDestination(hub, config);
+
+    // The handle stands for the tag set it was registered with, at the server
+    // it was registered with; other settings can change under it
+    const auto useHandle = config->compactTags
+                        && tagRegistration.state == TagRegistration::State::acknowledged
+                        && tagRegistration.target == &target
+                        && (tagRegistration.configVersion == config.getVersion() || tagRegistration.tags == config->tags);
+
+    const OSCLatencyProbe probe { event.entryMicros, instanceId };
+
+    if (!createOscMessage(event, config->wireFormat, useHandle ? tagRegistration.handleSuffix : config->tagSuffix, writer,
+                          config->latencyProbes ? &probe : nullptr))
     {
-        oscMessage.addString(tag);
+        OSCLog::write(OSCLog::Event::encodeFailed, event.status, writer.getSize());
+        metrics.encodeFailures.add();
+        return;
     }
 
-    DBG("Preparing to send OSC message: " << describeOscMessage(oscMessage));
+    metrics.messagesOut.add();
+    metrics.bytesOut.add(writer.getSize());
+    metrics.queueLatencyMicros.record(OSCLatencyProbe::nowMicros() - event.entryMicros);
+
+    // Bundled events share a datagram with those of every other instance
+    // sending to the same server in this pass of the transport thread
+    if (config->bundleEvents)
+        target.addToBundle(writer.getData(), writer.getSize(), static_cast<size_t>(config->maxDatagramSize), metrics.sendFailures);
+    else if (!target.send(writer.getData(), writer.getSize()))
+        metrics.sendFailures.add();
+}
 
-    // Attempt to send the message
-    if (oscSender.send(oscMessage))
+bool OSC_ClientAudioProcessor::createOscMessage(const OSCEvent& event, OSCWireFormat format, const OSCTagSuffix& suffix, OSCPacketWriter& writer,
+                                                const OSCLatencyProbe* probe)
+{
+    writer.reset();
+
+    if (format == OSCWireFormat::midi)
+        return OSCEventEncoder::writeMidiEvent(writer, event, suffix, probe);
+
+    return OSCEventEncoder::writeEvent(writer, event, suffix, probe);
+}
+
+void OSC_ClientAudioProcessor::serviceTagRegistration(OSCTransportHub& hub, double nowMs)
+{
+    const OSCConfigPublisher::ScopedRead config(configPublisher, OSCClientConfig::transportThreadReader);
+    auto& registration = tagRegistration;
+
+    if (!config->compactTags || config->tags.isEmpty())
     {
-        DBG("OSC message sent successfully: " << oscMessage.getAddressPattern().toString());
+        registration.state = TagRegistration::State::inactive;
+        compactTagsActive.store(false);
+        return;
     }
-    else
+
+    // The server can change without the config changing, when auto-connect
+    // picks another one
+    const auto* target = &getDestination(hub, config);
+
+    if (registration.configVersion != config.getVersion() || registration.target != target)
+    {
+        // Unrelated setting changes keep the handle; a new tag set or server needs a new one
+        const auto needsNewHandle = registration.state == TagRegistration::State::inactive
+                                 || registration.tags != config->tags
+                                 || registration.target != target;
+
+        registration.configVersion = config.getVersion();
+
+        if (needsNewHandle)
+        {
+            registration.state = TagRegistration::State::pending;
+            registration.tags = config->tags;
+            registration.target = target;
+            registration.nonce = nonceGenerator.nextInt();
+            registration.attempts = 0;
+            compactTagsActive.store(false);
+        }
+    }
+
+    switch (registration.state)
     {
-        DBG("Failed to send OSC message");
-        jassertfalse; // Assertion failure on failed send
+        case TagRegistration::State::pending:
+            if (registration.attempts == 0 || nowMs - registration.lastSentMs >= registrationRetryMs)
+            {
+                if (registration.attempts < maxRegistrationAttempts)
+                {
+                    sendTagRegistration(hub, config, nowMs);
+                }
+                else
+                {
+                    OSCLog::write(OSCLog::Event::tagRegistrationUnanswered);
+                    registration.state = TagRegistration::State::unsupported;
+                }
+            }
+            break;
+
+        case TagRegistration::State::acknowledged:
+            // Refresh periodically so a restarted server gets the mapping back.
+            // If refreshes go unanswered, drop back to strings and start over.
+            if (nowMs - registration.lastAckMs >= registrationRefreshMs + maxRegistrationAttempts * registrationRetryMs)
+            {
+                OSCLog::write(OSCLog::Event::tagHandleExpired);
+                registration.state = TagRegistration::State::pending;
+                registration.nonce = nonceGenerator.nextInt();
+                registration.attempts = 0;
+                compactTagsActive.store(false);
+            }
+            else if (nowMs - registration.lastAckMs >= registrationRefreshMs
+                     && nowMs - registration.lastSentMs >= registrationRetryMs)
+            {
+                sendTagRegistration(hub, config, nowMs);
+            }
+            break;
+
+        case TagRegistration::State::unsupported:
+            // Try again now and then in case the server has been upgraded or restarted
+            if (nowMs - registration.lastSentMs >= registrationRefreshMs)
+            {
+                registration.state = TagRegistration::State::pending;
+                registration.attempts = 0;
+            }
+            break;
+
+        case TagRegistration::State::inactive:
+            break;
     }
 }
 
+void OSC_ClientAudioProcessor::sendTagRegistration(OSCTransportHub& hub, const OSCConfigPublisher::ScopedRead& config, double nowMs)
+{
+    auto writer = hub.createPacketWriter();
+
+    if (OSCEventEncoder::writeTagRegistration(writer, tagRegistration.nonce, config->tagSuffix)
+        && !getDestination(hub, config).send(writer.getData(), writer.getSize()))
+        metrics.sendFailures.add();
+
+    ++tagRegistration.attempts;
+    tagRegistration.lastSentMs = nowMs;
+}
 
-juce::OSCMessage OSC_ClientAudioProcessor::createOscMessage(const juce::MidiMessage& message)
+void OSC_ClientAudioProcessor::handleServerReply(const OSCTransportHub::Destination& source, const char* data, int size, double nowMs)
 {
-	// Get current time in milliseconds
-	const double now = juce::Time::getMillisecondCounterHiRes();
-    const float timestamp = 0; //static_cast<float>(now);
+    // Replies for every instance sharing the socket arrive here; nonces, tags
+    // and handles pick out ours
+    if (&source != destination)
+        return;
+
+    metrics.datagramsReceived.add();
 
-    if (message.isNoteOn())
+    if (!OSCParser::validatePacket(data, static_cast<size_t>(size)))
     {
-        return juce::OSCMessage("/midi/message", juce::String("note_on"), message.getNoteNumber(), message.getVelocity(), timestamp);
+        metrics.parseErrors.add();
+        return;
     }
-    else if (message.isNoteOff())
+
+    replyReceivedMs = nowMs;
+
+    OSCParser::forEachMessage(data, static_cast<size_t>(size), [this](const OSCMessageView& message, juce::uint64 timeTag)
+    {
+        replyDispatcher.dispatch(message, timeTag);
+    });
+}
+
+void OSC_ClientAudioProcessor::handleTagAcknowledgement(const OSCMessageView& message)
+{
+    // "/client/tags_ack ,ii nonce handle"
+    if (!message.hasTypeTags("ii"))
+        return;
+
+    auto argument = message.begin();
+    const auto nonce = argument->getInt32();
+    const auto handle = (++argument)->getInt32();
+
+    if (tagRegistration.state == TagRegistration::State::inactive || nonce != tagRegistration.nonce)
+        return;
+
+    if (tagRegistration.state != TagRegistration::State::acknowledged || tagRegistration.handle != handle)
     {
-        return juce::OSCMessage("/midi/message", juce::String("note_off"), message.getNoteNumber(), timestamp);
+        OSCLog::write(OSCLog::Event::tagHandleAssigned, handle);
+        tagRegistration.handle = handle;
+        tagRegistration.handleSuffix = OSCTagSuffix::fromHandle(handle);
     }
-    else if (message.isController())
+
+    tagRegistration.state = TagRegistration::State::acknowledged;
+    tagRegistration.attempts = 0;
+    tagRegistration.lastAckMs = replyReceivedMs;
+    compactTagsActive.store(true);
+}
+
+void OSC_ClientAudioProcessor::handleIncomingMidi(const OSCMessageView& message)
+{
+    // The same layouts as outgoing raw MIDI:
+    //   /midi/raw ,mt midi timetag tag...  or  /midi/raw_id ,mti midi timetag handle
+    const OSCConfigPublisher::ScopedRead config(configPublisher, OSCClientConfig::transportThreadReader);
+    const auto typeTags = message.getTypeTags();
+
+    if (!config->receiveMidi || typeTags.substr(0, 2) != "mt")
+        return;
+
+    auto argument = message.begin();
+    const auto* midi = argument->getMidi();
+    const auto timeTag = (++argument)->getTimeTag();
+    ++argument;
+
+    if (message.hasAddress("/midi/raw_id"))
     {
-        return juce::OSCMessage("/midi/message", juce::String("controller"), message.getControllerNumber(), message.getControllerValue(), timestamp);
+        if (typeTags != "mti"
+            || tagRegistration.state != TagRegistration::State::acknowledged
+            || argument->getInt32() != tagRegistration.handle)
+            return;
     }
+    else
+    {
+        if (typeTags.size() - 2 != static_cast<size_t>(config->tags.size()))
+            return;
+
+        for (const auto& tag : config->tags)
+        {
+            if (!argument->isString() || argument->getString() != std::string_view(tag.toRawUTF8()))
+                return;
 
-    return juce::OSCMessage("/null");
+            ++argument;
+        }
+    }
+
+    // Channel voice messages only
+    if (midi[1] < 0x80 || midi[1] >= 0xf0)
+        return;
+
+    OSCEvent event;
+    event.status = midi[1];
+    event.data1 = midi[2] & 0x7f;
+    event.data2 = midi[3] & 0x7f;
+    event.timeTag = timeTag;
+
+    if (timeTag != OSCEventEncoder::immediateTimeTag)
+    {
+        const auto nowSeconds = static_cast<double>(juce::Time::currentTimeMillis()) / 1000.0;
+        lastIncomingMidiHeadroomMs.store((OSCEventEncoder::toSecondsSinceUnixEpoch(timeTag) - nowSeconds) * 1000.0, std::memory_order_relaxed);
+    }
+
+    if (incomingMidiQueue.push(event))
+    {
+        numIncomingMidiReceived.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        numIncomingMidiDropped.fetch_add(1, std::memory_order_relaxed);
+        OSCLog::write(OSCLog::Event::incomingMidiDropped);
+    }
+}
+
+void OSC_ClientAudioProcessor::handleStatsRequest(const OSCMessageView& message)
+{
+    // "/client/stats ,i nonce" or just "/client/stats". Every instance
+    // sending to the server answers for itself.
+    if (!message.hasTypeTags("i") && !message.hasTypeTags(""))
+        return;
+
+    const auto nonce = message.getNumArguments() == 1 ? message.begin()->getInt32() : 0;
+    const auto stats = getMetrics();
+    const auto midiIn = getIncomingMidiStats();
+    const OSCConfigPublisher::ScopedRead config(configPublisher, OSCClientConfig::transportThreadReader);
+
+    const OSCEventEncoder::StatValue values[] =
+    {
+        { "events_in",              stats.eventsIn },
+        { "events_coalesced",       stats.eventsCoalesced },
+        { "queue_overflows",        stats.queueOverflows },
+        { "events_truncated",       stats.eventsTruncated },
+        { "messages_out",           stats.messagesOut },
+        { "bytes_out",              stats.bytesOut },
+        { "send_failures",          stats.sendFailures },
+        { "encode_failures",        stats.encodeFailures },
+        { "datagrams_received",     stats.datagramsReceived },
+        { "parse_errors",           stats.parseErrors },
+        { "midi_in_received",       midiIn.numReceived },
+        { "midi_in_late",           midiIn.numLate },
+        { "midi_in_dropped",        midiIn.numDropped },
+        { "midi_in_held",           midiIn.numHeldForCapacity },
+        { "process_block_p50_us",   stats.processBlockMicros.getPercentile(50.0) },
+        { "process_block_p99_us",   stats.processBlockMicros.getPercentile(99.0) },
+        { "process_block_max_us",   stats.processBlockMicros.maximum },
+        { "queue_latency_p50_us",   stats.queueLatencyMicros.getPercentile(50.0) },
+        { "queue_latency_p99_us",   stats.queueLatencyMicros.getPercentile(99.0) },
+        { "queue_latency_max_us",   stats.queueLatencyMicros.maximum },
+    };
+
+    auto writer = transportHub->createPacketWriter();
+
+    if (OSCEventEncoder::writeStatsReply(writer, nonce, instanceId, values, static_cast<int>(std::size(values)), config->tagSuffix)
+        && !destination->send(writer.getData(), writer.getSize()))
+        metrics.sendFailures.add();
+}
+
+OSCClientMetrics::Snapshot OSC_ClientAudioProcessor::getMetrics() const
+{
+    OSCClientMetrics::Snapshot snapshot;
+    snapshot.eventsIn = metrics.eventsIn.get();
+    snapshot.eventsCoalesced = controllerCoalescer.getNumSuppressed();
+    snapshot.queueOverflows = eventQueue.getOverflowCount();
+    snapshot.eventsTruncated = metrics.eventsTruncated.get();
+    snapshot.messagesOut = metrics.messagesOut.get();
+    snapshot.bytesOut = metrics.bytesOut.get();
+    snapshot.sendFailures = metrics.sendFailures.get();
+    snapshot.encodeFailures = metrics.encodeFailures.get();
+    snapshot.datagramsReceived = metrics.datagramsReceived.get();
+    snapshot.parseErrors = metrics.parseErrors.get();
+    snapshot.processBlockMicros = metrics.processBlockMicros.getSnapshot();
+    snapshot.queueLatencyMicros = metrics.queueLatencyMicros.getSnapshot();
+    return snapshot;
+}
+
+OSC_ClientAudioProcessor::IncomingMidiStats OSC_ClientAudioProcessor::getIncomingMidiStats() const
+{
+    IncomingMidiStats stats;
+    stats.numReceived = numIncomingMidiReceived.load(std::memory_order_relaxed);
+    stats.numLate = numIncomingMidiLate.load(std::memory_order_relaxed);
+    stats.numDropped = numIncomingMidiDropped.load(std::memory_order_relaxed);
+    stats.numHeldForCapacity = numIncomingMidiHeldForCapacity.load(std::memory_order_relaxed);
+    stats.maxLateMs = maxIncomingMidiLateMs.load(std::memory_order_relaxed);
+    stats.lastHeadroomMs = lastIncomingMidiHeadroomMs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool OSC_ClientAudioProcessor::getAutoConnect() const
+{
+    const juce::ScopedLock sl(settingsLock);
+    return settings.autoConnect;
+}
+
+void OSC_ClientAudioProcessor::setAutoConnect(bool shouldAutoConnect)
+{
+    updateSettings([&](OSCClientConfig& config) { config.autoConnect = shouldAutoConnect; });
+}
+
+juce::String OSC_ClientAudioProcessor::getServerName() const
+{
+    const juce::ScopedLock sl(settingsLock);
+    return settings.serverName;
+}
+
+void OSC_ClientAudioProcessor::setServerName(const juce::String& newServerName)
+{
+    updateSettings([&](OSCClientConfig& config) { config.serverName = newServerName.trim(); });
+}
+
+juce::String OSC_ClientAudioProcessor::getConnectedServer() const
+{
+    const auto* target = activeDestination.load();
+    return target != nullptr ? target->getHost() + ":" + juce::String(target->getPort()) : juce::String();
+}
+
+bool OSC_ClientAudioProcessor::getReceiveMidi() const
+{
+    const juce::ScopedLock sl(settingsLock);
+    return settings.receiveMidi;
+}
+
+void OSC_ClientAudioProcessor::setReceiveMidi(bool shouldReceiveMidi)
+{
+    updateSettings([&](OSCClientConfig& config) { config.receiveMidi = shouldReceiveMidi; });
+}
+
+bool OSC_ClientAudioProcessor::getLatencyProbes() const
+{
+    const juce::ScopedLock sl(settingsLock);
+    return settings.latencyProbes;
+}
+
+void OSC_ClientAudioProcessor::setLatencyProbes(bool shouldSendProbes)
+{
+    updateSettings([&](OSCClientConfig& config) { config.latencyProbes = shouldSendProbes; });
 }
 
 juce::String OSC_ClientAudioProcessor::getIpAddress()
 {
+    const juce::ScopedLock sl(settingsLock);
     return juce::String(ipAddress);
 }
 
 void OSC_ClientAudioProcessor::setIpAddress(const juce::String& newIpAddress)
 {
+	const juce::ScopedLock sl(settingsLock);
 	this->ipAddress = newIpAddress;
 }
 
 int OSC_ClientAudioProcessor::getPort()
 {
+	const juce::ScopedLock sl(settingsLock);
 	return port;
 }
 
 void OSC_ClientAudioProcessor::setPort(int newPort)
 {
+	const juce::ScopedLock sl(settingsLock);
 	this->port = newPort;
 }
 
+bool OSC_ClientAudioProcessor::getBundleEvents() const
+{
+    const juce::ScopedLock sl(settingsLock);
+    return settings.bundleEvents;
+}
+
+void OSC_ClientAudioProcessor::setBundleEvents(bool shouldBundle)
+{
+    updateSettings([&](OSCClientConfig& config) { config.bundleEvents = shouldBundle; });
+}
+
+OSCWireFormat OSC_ClientAudioProcessor::getWireFormat() const
+{
+    const juce::ScopedLock sl(settingsLock);
+    return settings.wireFormat;
+}
+
+void OSC_ClientAudioProcessor::setWireFormat(OSCWireFormat newFormat)
+{
+    updateSettings([&](OSCClientConfig& config) { config.wireFormat = newFormat; });
+}
+
+OSCControllerFilter OSC_ClientAudioProcessor::getControllerFilter() const
+{
+    const juce::ScopedLock sl(settingsLock);
+    return settings.controllerFilter;
+}
+
+void OSC_ClientAudioProcessor::setControllerFilter(const OSCControllerFilter& newFilter)
+{
+    auto filter = newFilter;
+    filter.minIntervalMs = juce::jlimit(0.0, 10000.0, filter.minIntervalMs);
+    filter.minDelta = juce::jlimit(0, 127, filter.minDelta);
+
+    updateSettings([&](OSCClientConfig& config) { config.controllerFilter = filter; });
+}
+
+bool OSC_ClientAudioProcessor::getCompactTags() const
+{
+    const juce::ScopedLock sl(settingsLock);
+    return settings.compactTags;
+}
+
+void OSC_ClientAudioProcessor::setCompactTags(bool shouldUseCompactTags)
+{
+    updateSettings([&](OSCClientConfig& config) { config.compactTags = shouldUseCompactTags; });
+}
+
+int OSC_ClientAudioProcessor::getMaxDatagramSize() const
+{
+    const juce::ScopedLock sl(settingsLock);
+    return settings.maxDatagramSize;
+}
+
+void OSC_ClientAudioProcessor::setMaxDatagramSize(int newSize)
+{
+    const auto clampedSize = juce::jlimit(64, static_cast<int>(OSCEventEncoder::maxPacketSize), newSize);
+    updateSettings([&](OSCClientConfig& config) { config.maxDatagramSize = clampedSize; });
+}
+
 
 
 //==============================================================================
@@ -317,9 +914,20 @@ void OSC_ClientAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
     juce::ValueTree state("OSCClientState");
-    state.setProperty("IPAddress", ipAddress, nullptr);
-    state.setProperty("Port", port, nullptr);
-    state.setProperty("Tags", tags.joinIntoString("\n"), nullptr);
+    state.setProperty("IPAddress", getIpAddress(), nullptr);
+    state.setProperty("Port", getPort(), nullptr);
+    state.setProperty("Tags", getTags(), nullptr);
+    state.setProperty("BundleEvents", getBundleEvents(), nullptr);
+    state.setProperty("CompactTags", getCompactTags(), nullptr);
+    state.setProperty("ReceiveMidi", getReceiveMidi(), nullptr);
+    state.setProperty("AutoConnect", getAutoConnect(), nullptr);
+    state.setProperty("ServerName", getServerName(), nullptr);
+    const auto controllerFilter = getControllerFilter();
+    state.setProperty("CoalesceControllers", controllerFilter.coalesce, nullptr);
+    state.setProperty("ControllerMinIntervalMs", controllerFilter.minIntervalMs, nullptr);
+    state.setProperty("ControllerMinDelta", controllerFilter.minDelta, nullptr);
+    state.setProperty("WireFormat", getWireFormat() == OSCWireFormat::midi ? "midi" : "strings", nullptr);
+    state.setProperty("MaxDatagramSize", getMaxDatagramSize(), nullptr);
 
     std::unique_ptr<juce::XmlElement> xml(state.createXml());
     copyXmlToBinary(*xml, destData);
@@ -336,27 +944,37 @@ void OSC_ClientAudioProcessor::setStateInformation(const void* data, int sizeInB
         juce::ValueTree state = juce::ValueTree::fromXml(*xmlState);
         if (state.isValid())
         {
-            ipAddress = state.getProperty("IPAddress").toString();
-            port = state.getProperty("Port");
+            setIpAddress(state.getProperty("IPAddress").toString());
+            setPort(state.getProperty("Port"));
             setTags(state.getProperty("Tags").toString());
+            setBundleEvents(state.getProperty("BundleEvents", false));
+            setCompactTags(state.getProperty("CompactTags", false));
+            setReceiveMidi(state.getProperty("ReceiveMidi", false));
+            setAutoConnect(state.getProperty("AutoConnect", false));
+            setServerName(state.getProperty("ServerName").toString());
+            OSCControllerFilter controllerFilter;
+            controllerFilter.coalesce = state.getProperty("CoalesceControllers", true);
+            controllerFilter.minIntervalMs = state.getProperty("ControllerMinIntervalMs", 0.0);
+            controllerFilter.minDelta = state.getProperty("ControllerMinDelta", 0);
+            setControllerFilter(controllerFilter);
+            setWireFormat(state.getProperty("WireFormat").toString() == "midi" ? OSCWireFormat::midi : OSCWireFormat::strings);
+            setMaxDatagramSize(state.getProperty("MaxDatagramSize", static_cast<int>(OSCEventEncoder::defaultMaxDatagramSize)));
         }
     }
 }
 
 void OSC_ClientAudioProcessor::reConnect()
 {
-	// first disconnect
-	oscSender.disconnect();
+	// UDP is connectionless: just redirect subsequent sends
+	const juce::ScopedLock sl(settingsLock);
 
-	bool success = oscSender.connect(ipAddress, port);
-	if (success)
-	{
-		DBG("Connected to OSC server " << juce::String(ipAddress) << ":" << juce::String(port));
-	}
-	else
+	updateSettings([this](OSCClientConfig& config)
 	{
-		DBG("Failed to connect to OSC server");
-	}
+		config.ipAddress = ipAddress;
+		config.port = port;
+	});
+
+	DBG("Sending OSC to " << juce::String(ipAddress) << ":" << juce::String(port));
 }
 
 //==============================================================================
@@ -10,11 +10,20 @@
 
 #include <JuceHeader.h>
 #include "OSC.h"
+#include "OSCEventQueue.h"
+#include "OSCEncoder.h"
+#include "OSCConfig.h"
+#include "OSCMetrics.h"
+#include "OSCParser.h"
+#include "OSCAddressDispatcher.h"
+#include "OSCTransportHub.h"
+#include "RealtimeChecker.h"
 
 //==============================================================================
 /**
 */
-class OSC_ClientAudioProcessor  : public juce::AudioProcessor
+class OSC_ClientAudioProcessor  : public juce::AudioProcessor,
+                                  private OSCTransportHub::Client
 {
 public:
     //==============================================================================
@@ -35,8 +44,79 @@ public:
     juce::String getTags();
     void setTags(const juce::String& tagsString);
 
-    void sendOscMessage(const juce::MidiMessage& message);
-    juce::OSCMessage createOscMessage(const juce::MidiMessage& message);
+    // Called on the transport thread for every event queued by processBlock
+    void sendOscMessage(OSCTransportHub& hub, const OSCEvent& event);
+    bool createOscMessage(const OSCEvent& event, OSCWireFormat format, const OSCTagSuffix& suffix, OSCPacketWriter& writer,
+                          const OSCLatencyProbe* probe = nullptr);
+
+    // Queue statistics: current depth, high-water mark and dropped events
+    const OSCEventQueue& getEventQueue() const { return eventQueue; }
+
+    // Counters and latency histograms for the send and receive paths. Safe
+    // from any thread; the server can ask for the same figures with
+    // "/client/stats".
+    OSCClientMetrics::Snapshot getMetrics() const;
+
+    // Pack every event from one processBlock call into a single #bundle,
+    // split so that no datagram exceeds maxDatagramSize bytes
+    bool getBundleEvents() const;
+    void setBundleEvents(bool shouldBundle);
+    int getMaxDatagramSize() const;
+    void setMaxDatagramSize(int newSize);
+
+    // Wire layout of note and controller messages
+    OSCWireFormat getWireFormat() const;
+    void setWireFormat(OSCWireFormat newFormat);
+
+    // Controller thinning: per-block coalescing, minimum interval and minimum
+    // change per controller, and how many CCs were sent or suppressed
+    OSCControllerFilter getControllerFilter() const;
+    void setControllerFilter(const OSCControllerFilter& newFilter);
+    juce::uint64 getNumControllersSent() const        { return controllerCoalescer.getNumSent(); }
+    juce::uint64 getNumControllersSuppressed() const  { return controllerCoalescer.getNumSuppressed(); }
+
+    // Server auto-discovery: send to the announcing server called serverName,
+    // or the nearest one when it is empty, instead of the IP address and port
+    bool getAutoConnect() const;
+    void setAutoConnect(bool shouldAutoConnect);
+    juce::String getServerName() const;
+    void setServerName(const juce::String& newServerName);
+
+    // Where events are going now, as "host:port" (empty before the first send)
+    juce::String getConnectedServer() const;
+
+    // Bidirectional mode: MIDI the server sends back for this instrument (by
+    // tags or handle) is added to processBlock's output at the sample its
+    // time tag falls on
+    bool getReceiveMidi() const;
+    void setReceiveMidi(bool shouldReceiveMidi);
+
+    struct IncomingMidiStats
+    {
+        juce::uint64 numReceived = 0;
+        juce::uint64 numLate = 0;               // time tag had already passed when rendered
+        juce::uint64 numDropped = 0;            // queue full
+        juce::uint64 numHeldForCapacity = 0;    // times an event waited for room in the host's buffer
+        double maxLateMs = 0.0;
+        double lastHeadroomMs = 0.0;            // time tag minus arrival time of the latest event
+    };
+
+    IncomingMidiStats getIncomingMidiStats() const;
+
+    // Latency measurement mode: every event carries the time it entered
+    // processBlock and this instance's id, for a stand-in receiver such as
+    // Tools/OSCLatencyReceiver to measure against. Starts on if the
+    // OSC_CLIENT_LATENCY_PROBES environment variable is set to 1.
+    bool getLatencyProbes() const;
+    void setLatencyProbes(bool shouldSendProbes);
+    juce::int32 getInstanceId() const noexcept  { return instanceId; }
+
+    // Register the tag set with the server and send a small integer handle in
+    // place of the tag strings. Falls back to strings if the server never
+    // acknowledges; isUsingCompactTags() reports which is currently in use.
+    bool getCompactTags() const;
+    void setCompactTags(bool shouldUseCompactTags);
+    bool isUsingCompactTags() const { return compactTagsActive.load(); }
 
 	// Get and set ip address and port
 	juce::String getIpAddress();
@@ -72,18 +152,121 @@ public:
 	//==============================================================================
 	void reConnect();
 
-    // Create receiver
-    OSCMulticastReceiver receiver;
+    // The multicast receiver shared by all instances in the process
+    OSCMulticastReceiver& getMulticastReceiver() { return transportHub->getMulticastReceiver(); }
 
 private:
-    juce::OSCSender oscSender;
-    juce::StringArray tags = { juce::String("piano") }; // Explicit juce::String for clarity
-    juce::String lastDebugMessage;
+    // Sockets, bundles and the I/O thread are shared with every other
+    // instance in the process
+    juce::SharedResourcePointer<OSCTransportHub> transportHub;
+
+    // Events travel from processBlock to the transport thread through this ring.
+    // Each block is staged in stagedEvents, thinned into blockEvents by the
+    // controller coalescer and published in one go.
+    static constexpr int maxEventsPerBlock = 2048;
+    OSCEventQueue eventQueue { 4096 };
+    juce::HeapBlock<OSCEvent> stagedEvents { maxEventsPerBlock };
+    juce::HeapBlock<OSCEvent> blockEvents { maxEventsPerBlock };
+    OSCControllerCoalescer controllerCoalescer;
+    juce::uint32 blockCounter = 0;
+
+    // Tells the instances in the process apart in latency probes and stats
+    const juce::int32 instanceId;
+
+    OSCClientMetrics metrics;
+
+    // MIDI from the server: queued by the transport thread, then held on the
+    // audio thread until the block its time tag falls in
+    static constexpr int maxPendingIncomingMidi = 1024;
+    OSCEventQueue incomingMidiQueue { 1024 };
+    juce::HeapBlock<OSCEvent> pendingIncomingMidi { maxPendingIncomingMidi };
+    int numPendingIncomingMidi = 0;
 
-	// IP address and port
+    std::atomic<juce::uint64> numIncomingMidiReceived { 0 };
+    std::atomic<juce::uint64> numIncomingMidiLate { 0 };
+    std::atomic<juce::uint64> numIncomingMidiDropped { 0 };
+    std::atomic<juce::uint64> numIncomingMidiHeldForCapacity { 0 };
+    std::atomic<double> maxIncomingMidiLateMs { 0.0 };
+    std::atomic<double> lastIncomingMidiHeadroomMs { 0.0 };
+
+    void renderIncomingMidi(juce::MidiBuffer& midiMessages, int numSamples, double blockStartSeconds, bool enabled);
+    static bool canAddWithoutAllocating(const juce::MidiBuffer& buffer, int numBytes);
+
+    // The hub destination for the current config, touched only by the transport
+    // thread. With auto-connect it is chosen again whenever the server
+    // directory changes. Destinations live as long as the hub, so the message
+    // thread may read the host and port of the one published here.
+    OSCTransportHub::Destination* destination = nullptr;
+    juce::uint64 destinationConfigVersion = 0;
+    juce::uint32 destinationDirectoryGeneration = 0;
+    std::atomic<const OSCTransportHub::Destination*> activeDestination { nullptr };
+
+    OSCTransportHub::Destination& getDestination(OSCTransportHub& hub, const OSCConfigPublisher::ScopedRead& config);
+
+    // Sample-accurate block clock, used only on the audio thread
+    double currentSampleRate = 44100.0;
+    double wallClockOffsetMs = 0.0;
+    double blockClockAnchorMs = 0.0;
+    juce::int64 samplesSinceAnchor = 0;
+    bool blockClockAnchored = false;
+
+    // Returns the wall-clock start of the block in seconds since the Unix epoch
+    double advanceBlockClock(int numSamples);
+
+    // OSCTransportHub::Client
+    int serviceTransport(OSCTransportHub& hub, double nowMs) override;
+    void handleServerReply(const OSCTransportHub::Destination& source, const char* data, int size, double nowMs) override;
+    bool usesAutoConnect() override;
+
+    // Compact tag handshake, driven from every transport pass
+    struct TagRegistration
+    {
+        enum class State { inactive, pending, acknowledged, unsupported };
+
+        State state = State::inactive;
+        juce::uint64 configVersion = 0;     // the last config whose tags were checked against tags
+        juce::StringArray tags;
+        const OSCTransportHub::Destination* target = nullptr;
+        juce::int32 nonce = 0;
+        juce::int32 handle = 0;
+        int attempts = 0;
+        double lastSentMs = 0.0;
+        double lastAckMs = 0.0;
+        OSCTagSuffix handleSuffix;
+    } tagRegistration;
+
+    static constexpr double registrationRetryMs = 250.0;
+    static constexpr int maxRegistrationAttempts = 4;
+    static constexpr double registrationRefreshMs = 10000.0;
+
+    std::atomic<bool> compactTagsActive { false };
+    juce::Random nonceGenerator;
+
+    void serviceTagRegistration(OSCTransportHub& hub, double nowMs);
+    void sendTagRegistration(OSCTransportHub& hub, const OSCConfigPublisher::ScopedRead& config, double nowMs);
+
+    // Server replies, routed by address on the transport thread
+    OSCAddressDispatcher replyDispatcher;
+    double replyReceivedMs = 0.0;
+
+    void handleTagAcknowledgement(const OSCMessageView& message);
+    void handleIncomingMidi(const OSCMessageView& message);
+    void handleStatsRequest(const OSCMessageView& message);
+
+	// IP address and port as edited; they take effect on reConnect()
     juce::String ipAddress = "127.0.0.1";
 	int port = 8000;
 
+	// Message-thread copy of the live settings. Every change rebuilds it and
+	// publishes an immutable snapshot that the audio and transport threads pick
+	// up without locking.
+	juce::CriticalSection settingsLock;
+	OSCClientConfig settings;
+	OSCConfigPublisher configPublisher { settings };
+
+	template <typename Modifier>
+	void updateSettings(Modifier&& modify);
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OSC_ClientAudioProcessor)
 };
@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+    RealtimeChecker.h
+    Opt-in detection of allocations and blocking calls on the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+// Builds with OSC_CLIENT_REALTIME_CHECKS=1 (the CMake option of the same
+// name, for the benchmarks) record every heap allocation or free and every
+// blocking call (socket I/O, mutexes, condition variables, sleeps) made by
+// a thread while it is inside a ScopedSection, with the call stack. The
+// interposed functions live in Benchmarks/RealtimeChecker.cpp, which only
+// checked builds link; report() prints what was caught. In every other
+// build a ScopedSection is empty and costs nothing.
+#ifndef OSC_CLIENT_REALTIME_CHECKS
+ #define OSC_CLIENT_REALTIME_CHECKS 0
+#endif
+
+namespace RealtimeChecker
+{
+   #if OSC_CLIENT_REALTIME_CHECKS
+    void enterSection() noexcept;
+    void exitSection() noexcept;
+
+    // Prints each distinct offending call site, with its stack and how often
+    // it was hit, to stderr. Returns the total number of violations.
+    int report();
+   #endif
+
+    struct ScopedSection
+    {
+       #if OSC_CLIENT_REALTIME_CHECKS
+        ScopedSection() noexcept   { enterSection(); }
+        ~ScopedSection() noexcept  { exitSection(); }
+       #else
+        ScopedSection() noexcept {}
+       #endif
+
+        ScopedSection(const ScopedSection&) = delete;
+        ScopedSection& operator=(const ScopedSection&) = delete;
+    };
+}
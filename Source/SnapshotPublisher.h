@@ -0,0 +1,130 @@
+/*
+  ==============================================================================
+
+    SnapshotPublisher.h
+    Lock-free publication of immutable snapshots to real-time readers.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Publishes immutable, versioned snapshots from non-real-time writers to a
+// fixed set of reader threads (audio, sender, ...). Readers pick up the latest
+// snapshot with a couple of atomic operations: no locks, no allocation, no
+// frees. Each reader owns a slot in which it advertises the snapshot it is
+// using (a hazard pointer); writers only delete retired snapshots that no
+// slot refers to, so memory is always released on the writer's thread.
+template <typename Snapshot, int numReaders>
+class SnapshotPublisher
+{
+public:
+    struct Node
+    {
+        Snapshot value;
+        juce::uint64 version = 0;
+    };
+
+    explicit SnapshotPublisher(Snapshot initial)
+    {
+        current.store(new Node { std::move(initial), ++versionCounter });
+
+        for (auto& hazard : hazards)
+            hazard.store(nullptr);
+    }
+
+    ~SnapshotPublisher()
+    {
+        // Readers must have stopped by now
+        for (auto* node : retired)
+            delete node;
+
+        delete current.load();
+    }
+
+    //==============================================================================
+    // Writer side. Writers are serialised with a lock; they never run on a
+    // real-time thread.
+    void publish(Snapshot newSnapshot)
+    {
+        const juce::ScopedLock sl(writerLock);
+
+        auto* node = new Node { std::move(newSnapshot), ++versionCounter };
+        retired.push_back(current.exchange(node));
+        collectGarbage();
+    }
+
+    // Frees retired snapshots that are no longer referenced by any reader
+    void collectGarbage()
+    {
+        const juce::ScopedLock sl(writerLock);
+
+        retired.erase(std::remove_if(retired.begin(), retired.end(), [this](Node* node)
+        {
+            for (auto& hazard : hazards)
+                if (hazard.load() == node)
+                    return false;
+
+            delete node;
+            return true;
+        }), retired.end());
+    }
+
+    //==============================================================================
+    // Reader side. Each reader thread uses its own index in [0, numReaders)
+    // and holds at most one ScopedRead at a time.
+    class ScopedRead
+    {
+    public:
+        ScopedRead(SnapshotPublisher& publisher, int readerIndex) noexcept
+            : hazard(publisher.hazards[static_cast<size_t>(readerIndex)])
+        {
+            auto* candidate = publisher.current.load();
+
+            for (;;)
+            {
+                hazard.store(candidate);
+                auto* latest = publisher.current.load();
+
+                if (latest == candidate)
+                    break;
+
+                candidate = latest;
+            }
+
+            node = candidate;
+        }
+
+        ~ScopedRead()
+        {
+            hazard.store(nullptr);
+        }
+
+        const Snapshot& operator*() const noexcept   { return node->value; }
+        const Snapshot* operator->() const noexcept  { return &node->value; }
+        juce::uint64 getVersion() const noexcept     { return node->version; }
+
+    private:
+        std::atomic<Node*>& hazard;
+        const Node* node = nullptr;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedRead)
+    };
+
+private:
+    std::atomic<Node*> current { nullptr };
+    std::array<std::atomic<Node*>, (size_t) numReaders> hazards;
+
+    juce::CriticalSection writerLock;
+    std::vector<Node*> retired;
+    juce::uint64 versionCounter = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SnapshotPublisher)
+};
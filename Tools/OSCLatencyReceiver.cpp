@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    OSCLatencyReceiver.cpp
+    A stand-in server that measures how long events take to get from
+    processBlock to it.
+
+    Listens for OSC on a UDP port and reads the latency probe (see
+    OSCLatency.h) off every note and controller message as it arrives.
+    Every few seconds it prints p50, p99, p99.9 and worst latency in
+    microseconds for everything received in that interval, then one line
+    per plugin instance, and starts again.
+
+        OSCLatencyReceiver [port] [report interval seconds]
+
+    Point the plugin at this port (on the same machine: the probe clock is
+    not comparable between machines) and start the host with
+    OSC_CLIENT_LATENCY_PROBES=1 in its environment. Compare block sizes or
+    instance counts by changing them between intervals.
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include "../Source/OSCEncoder.h"
+#include "../Source/OSCLatency.h"
+#include "../Source/OSCParser.h"
+
+namespace
+{
+    void printLatency(const juce::String& label, const OSCLatencyHistogram& histogram)
+    {
+        std::printf("%-14s %9llu %9u %9u %9u %9u\n", label.toRawUTF8(), (unsigned long long) histogram.getCount(),
+                    histogram.getPercentile(50.0), histogram.getPercentile(99.0),
+                    histogram.getPercentile(99.9), histogram.getMax());
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int port = argc > 1 ? std::atoi(argv[1]) : 8000;
+    const double intervalMs = 1000.0 * (argc > 2 ? juce::jmax(0.1, std::atof(argv[2])) : 5.0);
+
+    juce::DatagramSocket socket;
+
+    if (!socket.bindToPort(port))
+    {
+        std::fprintf(stderr, "Could not bind to port %d\n", port);
+        return 1;
+    }
+
+    std::printf("Measuring latency probes on port %d\n", port);
+
+    juce::HeapBlock<char> buffer(OSCEventEncoder::maxPacketSize);
+    OSCLatencyHistogram overall;
+    std::map<juce::int32, OSCLatencyHistogram> perInstance;
+    int numWithoutProbe = 0;
+    double lastReportMs = juce::Time::getMillisecondCounterHiRes();
+
+    for (;;)
+    {
+        const auto nowMs = juce::Time::getMillisecondCounterHiRes();
+
+        if (nowMs - lastReportMs >= intervalMs)
+        {
+            std::printf("\n%-14s %9s %9s %9s %9s %9s\n", "latency us", "events", "p50", "p99", "p99.9", "max");
+            printLatency("all instances", overall);
+
+            for (const auto& [id, histogram] : perInstance)
+                printLatency("instance " + juce::String(id), histogram);
+
+            if (numWithoutProbe > 0)
+                std::printf("(%d messages without a probe)\n", numWithoutProbe);
+
+            overall.reset();
+            perInstance.clear();
+            numWithoutProbe = 0;
+            lastReportMs = nowMs;
+        }
+
+        if (socket.waitUntilReady(true, 10) <= 0)
+            continue;
+
+        const auto size = socket.read(buffer.getData(), static_cast<int>(OSCEventEncoder::maxPacketSize), false);
+        const auto arrivalMicros = OSCLatencyProbe::nowMicros();
+
+        if (size <= 0)
+            continue;
+
+        OSCParser::forEachMessage(buffer.getData(), static_cast<size_t>(size), [&](const OSCMessageView& message, juce::uint64)
+        {
+            OSCLatencyProbe probe;
+
+            if (OSCLatencyProbe::read(message, probe))
+            {
+                overall.record(probe.getAgeMicros(arrivalMicros));
+                perInstance[probe.instanceId].record(probe.getAgeMicros(arrivalMicros));
+            }
+            else
+            {
+                ++numWithoutProbe;
+            }
+        });
+    }
+}
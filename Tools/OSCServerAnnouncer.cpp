@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    OSCServerAnnouncer.cpp
+    A stand-in server for trying out auto-discovery without the real one.
+
+    Announces "/server/announce ,si name port" on the multicast group once a
+    second, answers "/server/ping" with "/server/pong" (optionally after an
+    artificial delay, to play a distant server) and counts everything else
+    that arrives on its OSC port.
+
+        OSCServerAnnouncer [name] [port] [extra latency ms]
+
+    Run two with different names, ports and delays, enable "Auto" in the
+    plugin and it should settle on the faster one; type a name into the
+    Server box to pin it to the other.
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include "../Source/OSCEncoder.h"
+#include "../Source/OSCParser.h"
+#include "../Source/OSCServerDiscovery.h"
+
+namespace
+{
+    struct PendingPong
+    {
+        double dueMs;
+        juce::String host;
+        int port;
+        juce::int32 nonce;
+    };
+
+    void sendPong(juce::DatagramSocket& socket, const PendingPong& pong)
+    {
+        char buffer[32];
+        OSCPacketWriter writer(buffer, sizeof(buffer));
+        writer.writeString(OSCServerDirectory::pongAddress);
+        writer.writeString(",i");
+        writer.writeInt32(pong.nonce);
+        socket.write(pong.host, pong.port, writer.getData(), static_cast<int>(writer.getSize()));
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const juce::String name = argc > 1 ? argv[1] : "stand-in";
+    const int port = argc > 2 ? std::atoi(argv[2]) : 8000;
+    const double extraLatencyMs = argc > 3 ? std::atof(argv[3]) : 0.0;
+
+    juce::DatagramSocket socket;
+
+    if (!socket.bindToPort(port))
+    {
+        std::fprintf(stderr, "Could not bind to port %d\n", port);
+        return 1;
+    }
+
+    std::printf("Announcing \"%s\" on %s:%d, OSC port %d, +%.1f ms\n", name.toRawUTF8(),
+                OSCServerDirectory::multicastGroup, OSCServerDirectory::multicastPort, port, extraLatencyMs);
+
+    juce::HeapBlock<char> buffer(OSCEventEncoder::maxPacketSize);
+    std::deque<PendingPong> pendingPongs;
+    double lastAnnounceMs = 0.0, lastReportMs = 0.0;
+    int numPings = 0, numMessages = 0;
+
+    for (;;)
+    {
+        const auto nowMs = juce::Time::getMillisecondCounterHiRes();
+
+        if (nowMs - lastAnnounceMs >= 1000.0)
+        {
+            char announcement[256];
+            OSCPacketWriter writer(announcement, sizeof(announcement));
+            writer.writeString(OSCServerDirectory::announceAddress);
+            writer.writeString(",si");
+            writer.writeString(name.toRawUTF8());
+            writer.writeInt32(port);
+
+            if (!writer.hasOverflowed())
+                socket.write(OSCServerDirectory::multicastGroup, OSCServerDirectory::multicastPort,
+                             writer.getData(), static_cast<int>(writer.getSize()));
+
+            lastAnnounceMs = nowMs;
+        }
+
+        if (nowMs - lastReportMs >= 5000.0)
+        {
+            std::printf("%d pings, %d other messages\n", numPings, numMessages);
+            lastReportMs = nowMs;
+        }
+
+        while (!pendingPongs.empty() && pendingPongs.front().dueMs <= nowMs)
+        {
+            sendPong(socket, pendingPongs.front());
+            pendingPongs.pop_front();
+        }
+
+        if (socket.waitUntilReady(true, 1) <= 0)
+            continue;
+
+        juce::String senderHost;
+        int senderPort = 0;
+        const auto size = socket.read(buffer.getData(), static_cast<int>(OSCEventEncoder::maxPacketSize), false, senderHost, senderPort);
+
+        if (size <= 0)
+            continue;
+
+        OSCParser::forEachMessage(buffer.getData(), static_cast<size_t>(size), [&](const OSCMessageView& message, juce::uint64)
+        {
+            if (message.hasAddress(OSCServerDirectory::pingAddress) && message.hasTypeTags("i"))
+            {
+                ++numPings;
+                pendingPongs.push_back({ nowMs + extraLatencyMs, senderHost, senderPort, message.begin()->getInt32() });
+            }
+            else
+            {
+                ++numMessages;
+            }
+        });
+    }
+}